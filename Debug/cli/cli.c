@@ -55,7 +55,7 @@ CLIDict_Entry( colorTest, "Displays a True Color ANSI test sequence to test term
 CLIDict_Entry( exit,      "Host KLL Only - Exits cli." );
 #endif
 CLIDict_Entry( help,      "You're looking at it :P" );
-CLIDict_Entry( latency,   "Show latency of specific modules and routiines. Specify index for a single item" );
+CLIDict_Entry( latency,   "Show latency of specific modules and routiines. Specify index for a single item" NL "\t\t\033[35mreset [i]\033[0m clears measurements, \033[35mdump\033[0m prints measurements and histograms in a machine-readable format" );
 CLIDict_Entry( led,       "Enables/Disables indicator LED. Try a couple times just in case the LED is in an odd state.\r\n\t\t\033[33mWarning\033[0m: May adversely affect some modules..." );
 CLIDict_Entry( periodic,  "Set the number of clock cycles between periodic scans." );
 CLIDict_Entry( rand,      "If entropy available, print a random 32-bit number." );
@@ -634,6 +634,64 @@ void printLatency( uint8_t resource )
 	printInt32( Latency_query( LatencyQuery_Last, resource ) );
 	print("\t");
 	printInt32( Latency_query( LatencyQuery_Max, resource ) );
+#if LatencyHistogram_define == 1
+	print("\t");
+	printInt32( Latency_query( LatencyQuery_P50, resource ) );
+	print("\t");
+	printInt32( Latency_query( LatencyQuery_P95, resource ) );
+	print("\t");
+	printInt32( Latency_query( LatencyQuery_P99, resource ) );
+	print("\t");
+	printInt32( Latency_query( LatencyQuery_P999, resource ) );
+#endif
+}
+
+// Machine-readable latency output
+// L,<i>,<module>,<unit>,<count>,<min>,<avg>,<last>,<max>,<p50>,<p95>,<p99>,<p99.9>
+// H,<i>,<bucket lower bound>:<bucket count>,... (only non-empty buckets)
+void dumpLatency( uint8_t resource )
+{
+	print("L,");
+	printInt8( resource );
+	print(",");
+	print( Latency_query_name( resource ) );
+	print(",");
+	print( Latency_option_name( resource ) );
+	const LatencyQuery queries[] = {
+		LatencyQuery_Count,
+		LatencyQuery_Min,
+		LatencyQuery_Average,
+		LatencyQuery_Last,
+		LatencyQuery_Max,
+		LatencyQuery_P50,
+		LatencyQuery_P95,
+		LatencyQuery_P99,
+		LatencyQuery_P999,
+	};
+	for ( uint8_t query = 0; query < sizeof( queries ) / sizeof( LatencyQuery ); query++ )
+	{
+		print(",");
+		printInt32( Latency_query( queries[query], resource ) );
+	}
+	print( NL );
+
+#if LatencyHistogram_define == 1
+	print("H,");
+	printInt8( resource );
+	for ( uint8_t bucket = 0; bucket < LatencyHistogramBuckets; bucket++ )
+	{
+		uint16_t count = Latency_bucket_count( bucket, resource );
+		if ( count == 0 )
+		{
+			continue;
+		}
+		print(",");
+		printInt32( Latency_bucket_lower( bucket ) );
+		print(":");
+		printInt16( count );
+	}
+	print( NL );
+#endif
 }
 
 void cliFunc_latency( char* args )
@@ -645,8 +703,40 @@ void cliFunc_latency( char* args )
 	CLI_argumentIsolation( args, &arg1Ptr, &arg2Ptr );
 
 	print( NL );
+
+	// Reset measurements, all resources if no index is given
+	if ( arg1Ptr[0] != '\0' && eqStr( arg1Ptr, "reset" ) == -1 )
+	{
+		char* arg3Ptr;
+		CLI_argumentIsolation( arg2Ptr, &arg2Ptr, &arg3Ptr );
+
+		for ( uint8_t c = 0; c < Latency_resources(); c++ )
+		{
+			if ( arg2Ptr[0] == '\0' || numToInt( arg2Ptr ) == c )
+			{
+				Latency_reset( c );
+			}
+		}
+		info_print("Latency reset");
+		return;
+	}
+
+	// Machine-readable dump of all resources
+	if ( arg1Ptr[0] != '\0' && eqStr( arg1Ptr, "dump" ) == -1 )
+	{
+		for ( uint8_t c = 0; c < Latency_resources(); c++ )
+		{
+			dumpLatency( c );
+		}
+		return;
+	}
+
 	print("Latency" NL );
+#if LatencyHistogram_define == 1
+	print("<i>:<module>\t<count>\t<min>\t<avg>\t<last>\t<max>\t<p50>\t<p95>\t<p99>\t<p99.9>");
+#else
 	print("<i>:<module>\t<count>\t<min>\t<avg>\t<last>\t<max>");
+#endif
 
 	// If no arguments print all
 	if ( arg1Ptr[0] == '\0' )
@@ -661,9 +751,10 @@ void cliFunc_latency( char* args )
 	else
 	{
 		print( NL );
-		if ( arg1Ptr[0] < Latency_resources() )
+		int resource = numToInt( arg1Ptr );
+		if ( resource >= 0 && resource < Latency_resources() )
 		{
-			printLatency( arg1Ptr[0] );
+			printLatency( resource );
 		}
 	}
 }
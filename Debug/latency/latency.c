@@ -79,12 +79,122 @@ uint8_t Latency_add_resource( const char* name, LatencyOption option )
 	// Set option
 	latency_measurements[index].option = option;
 
-	// Max out min latency
-	latency_measurements[index].min_latency = 0xFFFFFFFF;
+	// Clear measurements
+	Latency_reset( index );
 
 	return index;
 }
 
+// Reset latency measurements
+//
+// resource: index of resource
+void Latency_reset( uint8_t resource )
+{
+	LatencyMeasurement *measurement = &latency_measurements[resource];
+
+	// Max out min latency
+	measurement->min_latency = 0xFFFFFFFF;
+	measurement->max_latency = 0;
+	measurement->average_latency = 0;
+	measurement->last_latency = 0;
+	measurement->count = 0;
+
+#if LatencyHistogram_define == 1
+	memset( measurement->histogram, 0, sizeof(measurement->histogram) );
+#endif
+}
+
+// Histogram bucket of a measurement
+// Small values have their own bucket, larger values use the top LatencyHistogramSubBits_define bits after the MSB
+//
+// return: bucket index
+uint8_t Latency_bucket( uint32_t value )
+{
+	if ( value < ( 1 << ( LatencyHistogramSubBits_define + 1 ) ) )
+	{
+		return value;
+	}
+
+	uint8_t msb = 31 - __builtin_clz( value ); // clz = count leading zeros
+	uint8_t shift = msb - LatencyHistogramSubBits_define;
+	return ( shift << LatencyHistogramSubBits_define ) + ( value >> shift );
+}
+
+// Smallest value that falls into a bucket
+uint32_t Latency_bucket_lower( uint8_t bucket )
+{
+	if ( bucket < ( 1 << ( LatencyHistogramSubBits_define + 1 ) ) )
+	{
+		return bucket;
+	}
+
+	uint8_t shift = ( bucket >> LatencyHistogramSubBits_define ) - 1;
+	uint32_t mantissa = bucket - ( shift << LatencyHistogramSubBits_define );
+	return mantissa << shift;
+}
+
+// Largest value that falls into a bucket
+uint32_t Latency_bucket_upper( uint8_t bucket )
+{
+	if ( bucket + 1 >= LatencyHistogramBuckets )
+	{
+		return 0xFFFFFFFF;
+	}
+
+	return Latency_bucket_lower( bucket + 1 ) - 1;
+}
+
+// Number of measurements in a histogram bucket
+// Counts are relative, the histogram is halved whenever a bucket would overflow
+uint16_t Latency_bucket_count( uint8_t bucket, uint8_t resource )
+{
+#if LatencyHistogram_define == 1
+	return latency_measurements[resource].histogram[bucket];
+#else
+	return 0;
+#endif
+}
+
+// Query latency percentile
+// permille: percentile * 10 (e.g. 999 for p99.9)
+// resource: index of resource
+//
+// return: upper bound of the histogram bucket containing the percentile (limited to the max latency)
+uint32_t Latency_percentile( uint16_t permille, uint8_t resource )
+{
+#if LatencyHistogram_define == 1
+	LatencyMeasurement *measurement = &latency_measurements[resource];
+
+	// Total number of (possibly decayed) measurements
+	uint32_t total = 0;
+	for ( uint8_t bucket = 0; bucket < LatencyHistogramBuckets; bucket++ )
+	{
+		total += measurement->histogram[bucket];
+	}
+	if ( total == 0 )
+	{
+		return 0;
+	}
+
+	// Rank of the percentile, rounded up (total * permille can exceed 32 bits)
+	uint32_t rank = ( (uint64_t)total * permille + 999 ) / 1000;
+	uint32_t seen = 0;
+	for ( uint8_t bucket = 0; bucket < LatencyHistogramBuckets; bucket++ )
+	{
+		seen += measurement->histogram[bucket];
+		if ( seen >= rank )
+		{
+			uint32_t upper = Latency_bucket_upper( bucket );
+			return upper < measurement->max_latency ? upper : measurement->max_latency;
+		}
+	}
+
+	return measurement->max_latency;
+#else
+	return 0;
+#endif
+}
+
 // Query latency
 // type:     type of query
 // resource: index of resource
@@ -109,6 +219,18 @@ uint32_t Latency_query( LatencyQuery type, uint8_t resource )
 	case LatencyQuery_Count:
 		return latency_measurements[resource].count;
 
+	case LatencyQuery_P50:
+		return Latency_percentile( 500, resource );
+
+	case LatencyQuery_P95:
+		return Latency_percentile( 950, resource );
+
+	case LatencyQuery_P99:
+		return Latency_percentile( 990, resource );
+
+	case LatencyQuery_P999:
+		return Latency_percentile( 999, resource );
+
 	default:
 		return 0;
 	}
@@ -123,6 +245,28 @@ const char* Latency_query_name( uint8_t resource )
 	return latency_measurements[resource].name;
 }
 
+// Resource unit lookup
+// resource: index of resource
+//
+// return: Name of the measurement unit
+const char* Latency_option_name( uint8_t resource )
+{
+	switch ( latency_measurements[resource].option )
+	{
+	case LatencyOption_ms:
+		return "ms";
+
+	case LatencyOption_us:
+		return "us";
+
+	case LatencyOption_ns:
+		return "ns";
+
+	default:
+		return "ticks";
+	}
+}
+
 // Resource start time
 //
 // resource: index of resource
@@ -156,6 +300,16 @@ void Latency_end_time( uint8_t resource )
 		break;
 	}
 
+	Latency_add_measurement( resource, measured );
+}
+
+// Store latency measurement
+// Used directly when the latency is measured elsewhere (e.g. across modules)
+//
+// resource: index of resource
+// measured: latency, in the units of the resource
+void Latency_add_measurement( uint8_t resource, uint32_t measured )
+{
 	// Check if min or max latencies need to change
 	if ( measured < latency_measurements[resource].min_latency )
 	{
@@ -180,5 +334,20 @@ void Latency_end_time( uint8_t resource )
 
 	// Latency check count
 	latency_measurements[resource].count++;
+
+#if LatencyHistogram_define == 1
+	// Add to histogram, halving every bucket if the count would overflow
+	// Percentiles only depend on the relative counts, halving keeps them (mostly) intact while favouring recent values
+	uint16_t *histogram = latency_measurements[resource].histogram;
+	uint8_t bucket = Latency_bucket( measured );
+	if ( histogram[bucket] == LatencyHistogramMax )
+	{
+		for ( uint8_t b = 0; b < LatencyHistogramBuckets; b++ )
+		{
+			histogram[b] >>= 1;
+		}
+	}
+	histogram[bucket]++;
+#endif
 }
 
@@ -24,10 +24,25 @@
 // System Includes
 #include <Lib/time.h>
 
+// KLL Generated Defines
+#include <kll_defs.h>
+
 
 
 // ----- Defines -----
 
+// Log-bucketed histogram
+// Each power of 2 is split into 2^LatencyHistogramSubBits_define buckets
+// Values below 2^(LatencyHistogramSubBits_define + 1) each get their own bucket
+#define LatencyHistogramBuckets ( ( 33 - LatencyHistogramSubBits_define ) << LatencyHistogramSubBits_define )
+#define LatencyHistogramMax 0xFFFF
+
+#if LatencyHistogramSubBits_define > 3
+#error "latencyHistogramSubBits is a maximum of 3"
+#endif
+
+
+
 // ----- Enumerations -----
 
 typedef enum LatencyQuery {
@@ -36,6 +51,10 @@ typedef enum LatencyQuery {
 	LatencyQuery_Average = 2,
 	LatencyQuery_Last = 3,
 	LatencyQuery_Count = 4,
+	LatencyQuery_P50 = 5,
+	LatencyQuery_P95 = 6,
+	LatencyQuery_P99 = 7,
+	LatencyQuery_P999 = 8,
 } LatencyQuery;
 
 typedef enum LatencyOption {
@@ -58,6 +77,9 @@ typedef struct LatencyMeasurement {
 	uint32_t average_latency;
 	uint32_t last_latency;
 	uint32_t count;
+#if LatencyHistogram_define == 1
+	uint16_t histogram[LatencyHistogramBuckets];
+#endif
 } LatencyMeasurement;
 
 
@@ -69,6 +91,8 @@ typedef struct LatencyMeasurement {
 void Latency_init();
 void Latency_start_time( uint8_t resource );
 void Latency_end_time( uint8_t resource );
+void Latency_add_measurement( uint8_t resource, uint32_t measured );
+void Latency_reset( uint8_t resource );
 
 const char* Latency_query_name( uint8_t resource );
 
@@ -76,4 +100,12 @@ uint8_t Latency_add_resource( const char* name, LatencyOption option );
 uint8_t Latency_resources();
 
 uint32_t  Latency_query( LatencyQuery type, uint8_t resource );
+uint32_t  Latency_percentile( uint16_t permille, uint8_t resource );
+
+uint8_t  Latency_bucket( uint32_t value );
+uint32_t Latency_bucket_lower( uint8_t bucket );
+uint32_t Latency_bucket_upper( uint8_t bucket );
+uint16_t Latency_bucket_count( uint8_t bucket, uint8_t resource );
+
+const char* Latency_option_name( uint8_t resource );
 
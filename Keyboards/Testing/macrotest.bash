@@ -96,6 +96,11 @@ cmd python3 Tests/animation.py
 cmd python3 Tests/hidio.py
 cmd python3 Tests/cli.py
 cmd python3 Tests/layers.py
+cmd python3 Tests/layerlookup.py
+cmd python3 Tests/debounce.py
+cmd python3 Tests/latency.py
+cmd python3 Tests/fade.py
+cmd ./kiibohd_bench -n 2000
 
 # Tally results
 result
@@ -89,6 +89,19 @@ set ( TARGET_STATIC ${TARGET}_static )
 add_library ( ${TARGET_STATIC} STATIC ${SRCS} generatedKeymap.h )
 install ( TARGETS ${TARGET_STATIC} )
 
+#| Native host benchmark
+if ( DEFINED HOST AND DEFINED HostBench_SRCS )
+	add_executable ( ${TARGET}_bench ${HostBench_SRCS} )
+	target_link_libraries ( ${TARGET}_bench ${TARGET_STATIC} )
+
+	# Sanitizer runtime must also be linked into the executable
+	if ( DEFINED SANITIZER )
+		set_target_properties ( ${TARGET}_bench PROPERTIES
+			LINK_FLAGS "-fsanitize=undefined,address"
+		)
+	endif ()
+endif ()
+
 #| llvm-clang does not have an objcopy equivalent
 if ( "${COMPILER}" MATCHES "clang" )
 	if ( "${COMPILER_FAMILY}" MATCHES "arm" )
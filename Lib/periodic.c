@@ -46,6 +46,12 @@
 
 static void (*periodic_func)(void);
 
+// Periodic calls since the last Periodic_sync
+static volatile uint16_t periodic_sync_ticks = 0xFFFF;
+
+// Set by Periodic_syncClaim, cleared by Periodic_sync
+static volatile uint8_t periodic_sync_claimed = 0;
+
 #if defined(_host_)
 uint32_t Periodic_cycles_store = 0;
 #endif
@@ -100,8 +106,27 @@ uint32_t Periodic_cycles()
 	return PIT_LDVAL0;
 }
 
+void Periodic_sync()
+{
+	// Restart the count-down from the load value
+	PIT_TCTRL0 = PIT_TCTRL_TIE;
+	PIT_TCTRL0 = PIT_TCTRL_TIE | PIT_TCTRL_TEN;
+	periodic_sync_ticks = 0;
+	periodic_sync_claimed = 0;
+}
+
+uint16_t Periodic_ticksPerMs()
+{
+	// PIT is clocked from the bus clock
+	return F_BUS / 1000 / ( PIT_LDVAL0 + 1 );
+}
+
 void pit0_isr()
 {
+	// Count calls since the last sync
+	if ( periodic_sync_ticks != 0xFFFF )
+		periodic_sync_ticks++;
+
 	// Call specified function
 	(*periodic_func)();
 
@@ -158,6 +183,19 @@ uint32_t Periodic_cycles()
 	return TC0->TC_CHANNEL[2].TC_CV;
 }
 
+void Periodic_sync()
+{
+	// SAM4S TODO
+	periodic_sync_ticks = 0;
+	periodic_sync_claimed = 0;
+}
+
+uint16_t Periodic_ticksPerMs()
+{
+	// SAM4S TODO
+	return 0;
+}
+
 void TC2_Handler()
 {
 	SEGGER_SYSVIEW_RecordEnterISR();
@@ -218,6 +256,19 @@ uint32_t Periodic_cycles()
 	return TC1->TC_CHANNEL[2].TC_CV;
 }
 
+void Periodic_sync()
+{
+	// SAM TODO
+	periodic_sync_ticks = 0;
+	periodic_sync_claimed = 0;
+}
+
+uint16_t Periodic_ticksPerMs()
+{
+	// SAM TODO
+	return 0;
+}
+
 void TC5_Handler()
 {
 	SEGGER_SYSVIEW_RecordEnterISR();
@@ -258,6 +309,19 @@ uint32_t Periodic_cycles()
 	return 0;
 }
 
+void Periodic_sync()
+{
+	// NRF5 TODO
+	periodic_sync_ticks = 0;
+	periodic_sync_claimed = 0;
+}
+
+uint16_t Periodic_ticksPerMs()
+{
+	// NRF5 TODO
+	return 0;
+}
+
 
 #elif defined(_host_)
 void Periodic_init( uint32_t cycles )
@@ -283,5 +347,32 @@ uint32_t Periodic_cycles()
 {
 	return Periodic_cycles_store;
 }
+
+void Periodic_sync()
+{
+	// Not used on host
+	periodic_sync_ticks = 0;
+	periodic_sync_claimed = 0;
+}
+
+uint16_t Periodic_ticksPerMs()
+{
+	// Not used on host
+	return 0;
+}
 #endif
 
+
+
+// ----- Common Functions -----
+
+uint16_t Periodic_syncTicks()
+{
+	return periodic_sync_ticks;
+}
+
+uint8_t Periodic_syncClaim()
+{
+	// Atomic, Periodic_sync may be called from a higher priority interrupt
+	return __atomic_exchange_n( &periodic_sync_claimed, 1, __ATOMIC_SEQ_CST ) == 0;
+}
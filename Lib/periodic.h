@@ -42,3 +42,8 @@ void Periodic_enable();
 void Periodic_disable();
 uint32_t Periodic_cycles();
 
+void Periodic_sync();            // Re-phase the periodic timer to the caller (e.g. USB SOF)
+uint16_t Periodic_syncTicks();   // Periodic calls since the last Periodic_sync (saturates)
+uint8_t Periodic_syncClaim();    // Returns 1 on the first call since the last Periodic_sync, 0 afterwards
+uint16_t Periodic_ticksPerMs();  // Periodic calls per ms, 0 if unknown
+
@@ -363,14 +363,19 @@ Time Time_duration_rollover( Time now, Time since )
 
 	// Ticks do not rollover, they are computed from the last increment of ms
 	// Depending on the set clock speed, the maximum number of ticks per ms may vary
+	// 1 ms worth of ticks is borrowed so the subtraction cannot underflow
 	duration.ticks = now.ticks + ( Time_maxTicks - since.ticks );
 
-	// If ticks have exceeded 1 ms, increment ms
+	// If ticks have exceeded 1 ms, the borrowed ms was not needed
 	if ( duration.ticks >= Time_maxTicks )
 	{
-		duration.ms++;
 		duration.ticks -= Time_maxTicks;
 	}
+	// Otherwise take the borrowed ms (never underflow)
+	else if ( duration.ms > 0 )
+	{
+		duration.ms--;
+	}
 
 	return duration;
 }
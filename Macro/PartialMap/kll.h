@@ -345,6 +345,7 @@ typedef struct ResultPendingElem {
 	TriggerMacro     *trigger;
 	index_uint_t      index;
 	ResultMacroRecord record;
+	uint16_t          trace; // Trace event id, 0 if not traced
 } ResultPendingElem;
 
 // Results Pending - Ring-buffer definition
@@ -41,6 +41,9 @@
 // ----- Function Declarations -----
 
 void Layer_clearLayers();
+void Layer_invalidateLookupTable();
+
+nat_ptr_t *Layer_layerLookupStack( TriggerEvent *event, uint8_t latch_expire );
 
 
 
@@ -66,6 +69,19 @@ extern LayerStateType LayerState[];
 // Layer Index List
 extern const Layer LayerIndex[];
 
+#if LayerLookupTable_define == 1
+// Layer Lookup Table
+//  * Resolved trigger list (and source layer) for each scancode given the current layer stack
+//  * Marked stale on any layer state change, rebuilt on the next lookup
+nat_ptr_t *layerLookupTable[ MaxScanCode_KLL + 1 ];
+index_uint_t layerLookupTableLayer[ MaxScanCode_KLL + 1 ];
+uint8_t layerLookupTableStale;
+
+// Set if any layer in the stack has a latch pending
+// Latch expiry has side-effects, so these lookups must walk the layer stack
+uint8_t layerLookupTableLatched;
+#endif
+
 
 
 // ----- Capabilities -----
@@ -130,6 +146,9 @@ void Layer_layerStateSet( TriggerMacro *trigger, uint8_t state, uint8_t stateTyp
 		macroLayerIndexStackSize--;
 	}
 
+	// Layer stack/state has changed, lookup table must be rebuilt
+	Layer_invalidateLookupTable();
+
 	// Determine what signal to send about layer
 	if ( oldState && newState )
 	{
@@ -437,9 +456,85 @@ void Layer_clearLayers()
 
 	// Clear layer states
 	memset( &LayerState, 0, sizeof(LayerStateType) * LayerNum );
+
+	// Lookup table must be rebuilt
+	Layer_invalidateLookupTable();
+}
+
+
+// Marks the layer lookup table as stale
+// Must be called whenever LayerState or the layer stack is modified
+void Layer_invalidateLookupTable()
+{
+#if LayerLookupTable_define == 1
+	layerLookupTableStale = 1;
+#endif
 }
 
 
+#if LayerLookupTable_define == 1
+// Overlays the given layer onto the lookup table
+// Only scancodes that have triggers defined on the layer are replaced
+void Layer_overlayLookupTable( index_uint_t layerIndex )
+{
+	const Layer *layer = &LayerIndex[ layerIndex ];
+	nat_ptr_t **map = (nat_ptr_t**)layer->triggerMap;
+
+	// Ignore empty layers
+	if ( map == 0 )
+		return;
+
+	for ( uint16_t index = layer->first; index <= layer->last && index <= MaxScanCode_KLL; index++ )
+	{
+		// Only replace if layer has key defined
+		if ( *map[ index - layer->first ] != 0 )
+		{
+			layerLookupTable[ index ] = map[ index - layer->first ];
+			layerLookupTableLayer[ index ] = layerIndex;
+		}
+	}
+}
+
+
+// Rebuilds the layer lookup table from the current layer stack
+// Layers are overlaid from the bottom of the stack to the top, so the highest active layer with a
+// defined trigger list wins (same result as walking the stack from the top).
+void Layer_updateLookupTable()
+{
+	// Start with the default layer
+	memset( layerLookupTable, 0, sizeof( layerLookupTable ) );
+	Layer_overlayLookupTable( 0 );
+
+	layerLookupTableLatched = 0;
+	for ( index_uint_t stackItem = 0; stackItem < macroLayerIndexStackSize; stackItem++ )
+	{
+		index_uint_t layerIndex = macroLayerIndexStack[ stackItem ];
+
+		// Lookup each of the states
+		uint8_t shift = LayerState[ layerIndex ] & LayerStateType_Shift;
+		uint8_t latch = LayerState[ layerIndex ] & LayerStateType_Latch;
+		uint8_t lock = LayerState[ layerIndex ] & LayerStateType_Lock;
+
+		// Flag pending latches
+		if ( latch )
+		{
+			layerLookupTableLatched = 1;
+		}
+
+		// Only use layer, if state is valid
+		// XOR each of the state bits
+		// If only two are enabled, do not use this state
+		if ( (shift) ^ (latch>>1) ^ (lock>>2) )
+		{
+			Layer_overlayLookupTable( layerIndex );
+		}
+	}
+
+	layerLookupTableStale = 0;
+}
+#endif
+
+
 // Setup layers
 void Layer_setup()
 {
@@ -449,6 +544,9 @@ void Layer_setup()
 	// Set the current rotated layer to 0
 	Layer_rotationLayer = 0;
 
+	// Build lookup table on first lookup
+	Layer_invalidateLookupTable();
+
 	// Layer debug mode
 	layerDebugMode = 0;
 }
@@ -498,8 +596,56 @@ nat_ptr_t *Layer_layerLookup( TriggerEvent *event, uint8_t latch_expire )
 		return trigger_list;
 	}
 
+#if LayerLookupTable_define == 1
+	// Lookup table only applies to scancode events
+	// Layer events always use the default map (handled by the stack walk)
+	// If a latch may expire during this lookup, walk the layer stack instead
+	switch ( event->type )
+	{
+	case TriggerType_Layer1:
+	case TriggerType_Layer2:
+	case TriggerType_Layer3:
+	case TriggerType_Layer4:
+		break;
+
+	default:
+		if ( index > MaxScanCode_KLL )
+			break;
+
+		// Rebuild table if layer state has changed since the last lookup
+		if ( layerLookupTableStale )
+		{
+			Layer_updateLookupTable();
+		}
+
+		if ( latch_expire && layerLookupTableLatched )
+			break;
+
+		nat_ptr_t *trigger_list = layerLookupTable[ index ];
+
+		// Set the layer cache
+		if ( trigger_list != 0 )
+		{
+			macroTriggerEventLayerCache[ index ] = layerLookupTableLayer[ index ];
+		}
+
+		return trigger_list;
+	}
+#endif
+
+	return Layer_layerLookupStack( event, latch_expire );
+}
+
+
+// Looks up the trigger list for the given scan code by walking the layer stack
+// Also handles latch expiry for any latched layers above the selected layer
+// NOTE: Calling function must handle the NULL pointer case
+nat_ptr_t *Layer_layerLookupStack( TriggerEvent *event, uint8_t latch_expire )
+{
+	uint8_t index = event->index;
+
 	// If no trigger macro is defined at the given layer, fallthrough to the next layer
-	for ( uint16_t layerIndex = macroLayerIndexStackSize; layerIndex != 0xFFFF; layerIndex-- )
+	for ( uint16_t layerIndex = macroLayerIndexStackSize - 1; layerIndex != 0xFFFF; layerIndex-- )
 	{
 		// If this is a Layer trigger event, ignore other layers, always check the default map
 		switch ( event->type )
@@ -30,7 +30,9 @@
 
 void Layer_setup();
 void Layer_clearLayers();
+void Layer_invalidateLookupTable();
 index_uint_t Layer_topActive();
 
 nat_ptr_t *Layer_layerLookup( TriggerEvent *event, uint8_t latch_expire );
+nat_ptr_t *Layer_layerLookupStack( TriggerEvent *event, uint8_t latch_expire );
 
@@ -44,6 +44,7 @@
 #include "layer.h"
 #include "trigger.h"
 #include "result.h"
+#include "trace.h"
 #include "macro.h"
 
 
@@ -54,6 +55,7 @@ void cliFunc_capDebug  ( char* args );
 void cliFunc_capList   ( char* args );
 void cliFunc_capSelect ( char* args );
 void cliFunc_keyHold   ( char* args );
+void cliFunc_keyLatency( char* args );
 void cliFunc_keyPress  ( char* args );
 void cliFunc_keyRelease( char* args );
 void cliFunc_layerDebug( char* args );
@@ -79,6 +81,7 @@ CLIDict_Entry( capDebug,    "Prints capability debug message before calling, wit
 CLIDict_Entry( capList,     "Prints an indexed list of all non USB keycode capabilities." );
 CLIDict_Entry( capSelect,   "Triggers the specified capabilities. First two args are state and stateType." NL "\t\t\033[35mK11\033[0m Keyboard Capability 0x0B" );
 CLIDict_Entry( keyHold,     "Send key-hold events to the macro module. Duplicates have undefined behaviour." NL "\t\t\033[35mS10\033[0m Scancode 0x0A" );
+CLIDict_Entry( keyLatency,  "Show key event to USB report latency of the most recent key events." );
 CLIDict_Entry( keyPress,    "Send key-press events to the macro module. Duplicates have undefined behaviour." NL "\t\t\033[35mS10\033[0m Scancode 0x0A" );
 CLIDict_Entry( keyRelease,  "Send key-release event to macro module. Duplicates have undefined behaviour." NL "\t\t\033[35mS10\033[0m Scancode 0x0A" );
 CLIDict_Entry( layerDebug,  "Layer debug mode. Shows layer stack and any changes." );
@@ -97,6 +100,7 @@ CLIDict_Def( macroCLIDict, "Macro Module Commands" ) = {
 	CLIDict_Item( capList ),
 	CLIDict_Item( capSelect ),
 	CLIDict_Item( keyHold ),
+	CLIDict_Item( keyLatency ),
 	CLIDict_Item( keyPress ),
 	CLIDict_Item( keyRelease ),
 	CLIDict_Item( layerDebug ),
@@ -149,6 +153,24 @@ static uint8_t macroLatencyResource;
 TriggerEvent macroTriggerEventBuffer[ MaxScanCode_KLL + 1 ];
 var_uint_t macroTriggerEventBufferSize;
 
+// Incoming Scan Event Queue
+// Single producer (scan module, may run from an ISR), single consumer (Macro_periodic) ring buffer
+// Drained into macroTriggerEventBuffer at the start of each macro processing loop
+// Events raised from macro/result processing (e.g. rotations) are written directly into macroTriggerEventBuffer
+// One slot is always left empty to tell a full queue from an empty one
+// Half of the queue is reserved for state changes (e.g. Press/Release), Hold events are dropped first
+#define MacroTriggerEventQueueReserve ( MaxScanCode_KLL + 1 )
+#define MacroTriggerEventQueueSize ( MacroTriggerEventQueueReserve * 2 + 1 )
+TriggerEvent macroTriggerEventQueue[ MacroTriggerEventQueueSize ];
+uint16_t macroTriggerEventQueueHead; // Written by consumer
+uint16_t macroTriggerEventQueueTail; // Written by producer
+uint32_t macroTriggerEventQueueDropped; // Events dropped due to a full queue
+
+// Set while a Hold event of the ScanCode is queued, further Holds are merged into it
+// Keeps a held key from filling the queue while Macro_periodic is held off (e.g. during a delayed capability)
+// Set by the producer before queueing, cleared by the consumer when draining
+volatile uint8_t macroTriggerEventQueueHold[ MaxScanCode_KLL + 1 ];
+
 extern ResultsPending macroResultMacroPendingList;
 extern index_uint_t macroTriggerMacroPendingList[];
 extern index_uint_t macroTriggerMacroPendingListSize;
@@ -574,6 +596,9 @@ uint8_t Macro_pressReleaseAdd( void *trigger_ptr )
 		return 2;
 	}
 
+	// Start latency trace of key transitions
+	Trace_keyEvent( trigger->type, trigger->index, trigger->state );
+
 	// Add trigger to the Interconnect Cache
 	// During each processing loop, a scancode may be re-added depending on it's state
 	for ( var_uint_t c = 0; c < macroInterconnectCacheSize; c++ )
@@ -595,6 +620,70 @@ uint8_t Macro_pressReleaseAdd( void *trigger_ptr )
 #endif
 
 
+// Queue a scan event for the next macro processing loop
+// transition is set for state changes (e.g. Press/Release), these may use the reserved part of the queue
+// Does not block, the event is dropped if the queue is full
+// Returns 1 if queued, 0 if dropped
+static uint8_t Macro_queueTriggerEvent( uint8_t type, uint8_t state, uint8_t index, uint8_t transition )
+{
+	uint16_t tail = macroTriggerEventQueueTail;
+	uint16_t head = __atomic_load_n( &macroTriggerEventQueueHead, __ATOMIC_ACQUIRE );
+	uint16_t used = tail >= head ? tail - head : MacroTriggerEventQueueSize - head + tail;
+	uint16_t room = MacroTriggerEventQueueSize - 1 - used;
+
+	// Queue full (Hold and other repeated events leave the reserve for state changes)
+	if ( room == 0 || ( !transition && room <= MacroTriggerEventQueueReserve ) )
+	{
+		macroTriggerEventQueueDropped++;
+		return 0;
+	}
+
+	uint16_t next = tail + 1 >= MacroTriggerEventQueueSize ? 0 : tail + 1;
+
+	macroTriggerEventQueue[ tail ].index = index;
+	macroTriggerEventQueue[ tail ].state = state;
+	macroTriggerEventQueue[ tail ].type  = type;
+
+	// Hand event over to the consumer
+	__atomic_store_n( &macroTriggerEventQueueTail, next, __ATOMIC_RELEASE );
+	return 1;
+}
+
+// Move queued scan events into macroTriggerEventBuffer
+// Events that don't fit stay queued until the next processing loop
+static void Macro_drainTriggerEventQueue()
+{
+	uint16_t head = macroTriggerEventQueueHead;
+	uint16_t tail = __atomic_load_n( &macroTriggerEventQueueTail, __ATOMIC_ACQUIRE );
+
+	while ( head != tail && macroTriggerEventBufferSize + 1 < MaxScanCode_KLL )
+	{
+		TriggerEvent *event = &macroTriggerEventQueue[ head ];
+		macroTriggerEventBuffer[ macroTriggerEventBufferSize++ ] = *event;
+
+		// Allow the next Hold of this ScanCode to be queued
+		if ( event->type <= TriggerType_Switch4 && event->state == ScheduleType_H )
+		{
+			macroTriggerEventQueueHold[ event->type * 256 + event->index ] = 0;
+		}
+
+		if ( ++head >= MacroTriggerEventQueueSize )
+			head = 0;
+	}
+
+	// Hand slots back to the producer
+	__atomic_store_n( &macroTriggerEventQueueHead, head, __ATOMIC_RELEASE );
+}
+
+// Discard any queued scan events
+// Only call from the consumer context (or when the scan module is idle)
+void Macro_clearTriggerEventQueue()
+{
+	__atomic_store_n( &macroTriggerEventQueueHead, __atomic_load_n( &macroTriggerEventQueueTail, __ATOMIC_ACQUIRE ), __ATOMIC_RELEASE );
+	memset( (void*)macroTriggerEventQueueHold, 0, sizeof( macroTriggerEventQueueHold ) );
+}
+
+
 // Update the scancode key state
 // States:
 //   * 0x00 - Off
@@ -658,10 +747,25 @@ void Macro_keyState( uint16_t scanCode, uint8_t state )
 			type = TriggerType_Switch4;
 		}
 
-		macroTriggerEventBuffer[ macroTriggerEventBufferSize ].index = index;
-		macroTriggerEventBuffer[ macroTriggerEventBufferSize ].state = state;
-		macroTriggerEventBuffer[ macroTriggerEventBufferSize ].type  = type;
-		macroTriggerEventBufferSize++;
+		// A Hold of this ScanCode is still queued, merge into it
+		if ( state == ScheduleType_H )
+		{
+			if ( macroTriggerEventQueueHold[ scanCode ] )
+				return;
+			macroTriggerEventQueueHold[ scanCode ] = 1;
+		}
+
+		if ( !Macro_queueTriggerEvent( type, state, index, state != ScheduleType_H ) )
+		{
+			if ( state == ScheduleType_H )
+				macroTriggerEventQueueHold[ scanCode ] = 0;
+
+			// Dropped events never reach Trigger_process, don't trace them
+			break;
+		}
+
+		// Start latency trace of key transitions
+		Trace_keyEvent( type, index, state );
 		break;
 	}
 }
@@ -703,10 +807,8 @@ void Macro_analogState( uint16_t scanCode, uint8_t state )
 		type = TriggerType_Analog4;
 	}
 
-	macroTriggerEventBuffer[ macroTriggerEventBufferSize ].index = index;
-	macroTriggerEventBuffer[ macroTriggerEventBufferSize ].state = state;
-	macroTriggerEventBuffer[ macroTriggerEventBufferSize ].type  = type;
-	macroTriggerEventBufferSize++;
+	// Only Released is a state change, analog values repeat every scan
+	Macro_queueTriggerEvent( type, state, index, state == 0x01 );
 }
 
 
@@ -952,6 +1054,7 @@ void Macro_rotationState( uint8_t index, int8_t increment )
 	Macro_rotation_store[index] = position;
 
 	// Queue event
+	// Raised by Macro_rotate_capability during macro/result processing (consumer side), not by a scan module
 	macroTriggerEventBuffer[ macroTriggerEventBufferSize ].index = index;
 	macroTriggerEventBuffer[ macroTriggerEventBufferSize ].state = position;
 	macroTriggerEventBuffer[ macroTriggerEventBufferSize ].type  = type;
@@ -974,10 +1077,7 @@ void Macro_dialState( uint8_t index, uint8_t state )
 	{
 	case ScheduleType_Inc: // Increment
 	case ScheduleType_Dec: // Decrement
-		macroTriggerEventBuffer[ macroTriggerEventBufferSize ].index = index;
-		macroTriggerEventBuffer[ macroTriggerEventBufferSize ].state = state;
-		macroTriggerEventBuffer[ macroTriggerEventBufferSize ].type  = type;
-		macroTriggerEventBufferSize++;
+		Macro_queueTriggerEvent( type, state, index, 1 );
 		break;
 	}
 }
@@ -1039,9 +1139,19 @@ void Macro_poll()
 // Called once per USB buffer send
 void Macro_periodic()
 {
+	// Hold off while Macro_poll is running a delayed (non-thread-safe) capability
+	// Scan events keep queueing up and are processed on the next call
+	if ( __atomic_load_n( &macroResultDelayedActive, __ATOMIC_ACQUIRE ) )
+	{
+		return;
+	}
+
 	// Latency measurement
 	Latency_start_time( macroLatencyResource );
 
+	// Collect scan events queued since the last processing loop
+	Macro_drainTriggerEventQueue();
+
 #if defined(ConnectEnabled_define)
 	// Only compile in if a Connect node module is available
 	// If this is a interconnect slave node, send all scancodes to master node
@@ -1049,8 +1159,33 @@ void Macro_periodic()
 	{
 		if ( macroTriggerEventBufferSize > 0 )
 		{
-			Connect_send_ScanCode( Connect_id, macroTriggerEventBuffer, macroTriggerEventBufferSize );
-			macroTriggerEventBufferSize = 0;
+			// If the interconnect Tx buffer is backed up, keep the events for the next period
+			if ( Connect_send_ScanCode( Connect_id, macroTriggerEventBuffer, macroTriggerEventBufferSize ) )
+			{
+				macroTriggerEventBufferSize = 0;
+			}
+			// Event buffer is getting close to overflowing, make room by dropping Hold/Off events first
+			// Press/Release events are only dropped if there are still too many of them
+			else if ( macroTriggerEventBufferSize > MaxScanCode_KLL / 2 )
+			{
+				var_uint_t kept = 0;
+				for ( var_uint_t pos = 0; pos < macroTriggerEventBufferSize; pos++ )
+				{
+					switch ( macroTriggerEventBuffer[ pos ].state )
+					{
+					case ScheduleType_P:
+					case ScheduleType_R:
+						macroTriggerEventBuffer[ kept++ ] = macroTriggerEventBuffer[ pos ];
+						break;
+					}
+				}
+				if ( kept > MaxScanCode_KLL / 2 )
+				{
+					kept = 0;
+				}
+				Connect_scanCodeTxDropped += macroTriggerEventBufferSize - kept;
+				macroTriggerEventBufferSize = kept;
+			}
 		}
 		return;
 	}
@@ -1240,6 +1375,9 @@ inline void Macro_setup()
 	// Setup Results
 	Result_setup();
 
+	// Setup key event tracing
+	Trace_setup();
+
 	// Allocate resource for latency measurement
 	macroLatencyResource = Latency_add_resource("PartialMap", LatencyOption_Ticks);
 }
@@ -1383,6 +1521,40 @@ void cliFunc_keyHold( char* args )
 	}
 }
 
+void cliFunc_keyLatency( char* args )
+{
+	print( NL );
+	info_print("Key Latency (most recent first)");
+
+	for ( uint8_t pos = 0; pos < Trace_records(); pos++ )
+	{
+		const TraceRecord *record = Trace_record( pos );
+		if ( record == 0 )
+		{
+			break;
+		}
+
+		print( NL "\t" );
+		printInt16( record->id );
+		print(" ");
+		printHex( record->type );
+		print(":");
+		printHex( record->index );
+		print(" ");
+		printHex( record->state );
+		print(" ");
+		if ( record->sent )
+		{
+			printInt32( record->latency );
+			print(" us");
+		}
+		else
+		{
+			print("-");
+		}
+	}
+}
+
 void cliFunc_keyPress( char* args )
 {
 	// Parse codes from arguments
@@ -1522,6 +1694,7 @@ void cliFunc_layerState( char* args )
 
 			// Set the layer state
 			LayerState[ arg1 ] = arg2;
+			Layer_invalidateLookupTable();
 			break;
 		}
 	}
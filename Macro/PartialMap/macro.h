@@ -26,6 +26,12 @@
 
 
 
+// ----- Variables -----
+
+extern volatile uint8_t macroResultDelayedActive; // Set while Macro_poll runs a delayed capability
+
+
+
 // ----- Functions -----
 
 void Macro_analogState( uint16_t scanCode, uint8_t state );
@@ -39,6 +45,8 @@ void Macro_dialState( uint8_t index, uint8_t state );
 
 uint8_t Macro_tick_update( TickStore *store, uint8_t type );
 
+void Macro_clearTriggerEventQueue();
+
 void Macro_periodic();
 void Macro_poll();
 void Macro_setup();
@@ -18,7 +18,6 @@
 
 // Compiler Includes
 #include <Lib/MacroLib.h>
-#include <Lib/periodic.h>
 
 // Project Includes
 #include <led.h>
@@ -26,6 +25,7 @@
 
 // Local Includes
 #include "result.h"
+#include "trace.h"
 #include "kll.h"
 
 
@@ -48,11 +48,17 @@ typedef struct ResultCapabilityStackItem {
 	uint8_t       stateType;
 	uint8_t       capabilityIndex;
 	uint8_t      *args;
+	uint16_t      trace;
 } ResultCapabilityStackItem;
 
+// Single producer (Macro_periodic) / single consumer (Macro_poll) ring of delayed capabilities
+//  * head is only written by the consumer, tail only by the producer
+//  * One slot is kept empty to distinguish full from empty
+#define ResultDelayedRingSize ( ResultCapabilityStackSize_define + 1 )
 typedef struct ResultCapabilityStack {
-	ResultCapabilityStackItem stack[ ResultCapabilityStackSize_define ];
-	uint8_t                   size;
+	ResultCapabilityStackItem stack[ ResultDelayedRingSize ];
+	uint8_t                   head;
+	uint8_t                   tail;
 } ResultCapabilityStack;
 
 
@@ -67,6 +73,8 @@ extern ResultMacroRecord ResultMacroRecordList[];
 extern var_uint_t macroTriggerEventBufferSize;
 extern TriggerEvent macroTriggerEventBuffer[];
 
+extern const TriggerMacro TriggerMacroList[];
+
 
 
 // ----- Variables -----
@@ -75,8 +83,38 @@ extern TriggerEvent macroTriggerEventBuffer[];
 //  * Any result macro that needs processing from a previous macro processing loop
 ResultsPending macroResultMacroPendingList;
 
-// Delayed capabilities stack
-volatile ResultCapabilityStack macroResultDelayedCapabilities;
+// Delayed capabilities ring
+ResultCapabilityStack macroResultDelayedCapabilities;
+
+// Delayed capability de-duplication index
+//  * Hashed (trigger, capability, state, args) -> ring slot + 1 (0 is empty), 2-way (hash and hash + 1)
+//  * Only used by the producer, an entry is a duplicate only if the slot is still pending and matches
+//  * If both buckets are pending, the first is overwritten (worst case a duplicate is queued)
+#define ResultDelayedIndexSize ( ResultDelayedRingSize * 4 )
+uint8_t macroResultDelayedIndex[ ResultDelayedIndexSize ];
+
+// Set while Macro_poll is running a delayed capability, Macro_periodic is held off until it finishes
+volatile uint8_t macroResultDelayedActive;
+
+// Trigger Event Index
+//  * Open-addressed hash table, (TriggerType, index) -> macroTriggerEventBuffer position + 1 (0 is empty)
+//  * Rebuilt once per macro processing loop, before any result macros are appended
+//  * Sized to twice the largest event buffer to keep probe sequences short
+#define ResultEventIndexSize ( ( MaxScanCode_KLL + 1 ) * 2 )
+uint16_t macroTriggerEventIndex[ ResultEventIndexSize ];
+
+// Slots of macroTriggerEventIndex written by the last rebuild
+//  * Only these are cleared on the next rebuild, so an idle loop costs O(events) rather than O(MaxScanCode)
+uint16_t macroTriggerEventIndexUsed[ MaxScanCode_KLL + 1 ];
+var_uint_t macroTriggerEventIndexUsedSize;
+
+// Last combo position of each TriggerMacro guide
+//  * Computed during setup (guides are constant)
+#if TriggerMacroNum_KLL == 0
+var_uint_t resultTriggerMacroLastCombo[ 1 ];
+#else
+var_uint_t resultTriggerMacroLastCombo[ TriggerMacroNum_KLL ];
+#endif
 
 #if defined(_host_)
 // Host-side KLL capability callback data
@@ -96,6 +134,81 @@ extern int Output_callback( char* command, char* args );
 #endif
 
 
+// Hash a delayed capability into the de-duplication index
+static uint16_t Result_delayedHash( const TriggerMacro *trigger, uint8_t state, uint8_t stateType, uint8_t capabilityIndex, const uint8_t *args )
+{
+	uint32_t key = (uint32_t)(uintptr_t)trigger ^ ( (uint32_t)(uintptr_t)args << 5 );
+	key ^= ( capabilityIndex << 16 ) | ( state << 8 ) | stateType;
+	key *= 2654435761u; // Knuth multiplicative hash
+	return ( key >> 16 ) % ResultDelayedIndexSize;
+}
+
+
+// Queue a non-thread-safe capability to be called from Macro_poll
+// Identical capabilities (same trigger, state, capability and args) that are still pending are not queued again
+// Lock-free, the consumer (Result_process_delayed) only ever advances the head
+static void Result_queueDelayed( ResultPendingElem *resultElem, ResultMacroRecord *record, ResultGuide *guide )
+{
+	uint8_t head = __atomic_load_n( &macroResultDelayedCapabilities.head, __ATOMIC_ACQUIRE );
+	uint8_t tail = macroResultDelayedCapabilities.tail;
+	uint8_t pending = ( tail + ResultDelayedRingSize - head ) % ResultDelayedRingSize;
+	uint16_t hash = Result_delayedHash( resultElem->trigger, record->state, record->stateType, guide->index, &guide->args );
+	uint16_t insert = hash;
+	uint8_t reuse = 0;
+
+	// Check if the same capability is still pending
+	for ( uint8_t probe = 0; probe < 2; probe++ )
+	{
+		uint16_t bucket = ( hash + probe ) % ResultDelayedIndexSize;
+		uint8_t slot = macroResultDelayedIndex[ bucket ];
+
+		// Empty, or slot already processed, bucket can be reused
+		if ( slot == 0 || ( slot - 1 + ResultDelayedRingSize - head ) % ResultDelayedRingSize >= pending )
+		{
+			if ( !reuse )
+			{
+				insert = bucket;
+				reuse = 1;
+			}
+			continue;
+		}
+
+		ResultCapabilityStackItem *item = &macroResultDelayedCapabilities.stack[ slot - 1 ];
+		if (
+			item->trigger == resultElem->trigger &&
+			item->state == record->state &&
+			item->stateType == record->stateType &&
+			item->capabilityIndex == guide->index &&
+			item->args == &guide->args
+		)
+		{
+			// Don't add
+			return;
+		}
+	}
+
+	// Check for a full ring
+	uint8_t next = tail + 1 >= ResultDelayedRingSize ? 0 : tail + 1;
+	if ( next == head )
+	{
+		warn_printNL("Delayed capability stack full!");
+		return;
+	}
+
+	ResultCapabilityStackItem *item = &macroResultDelayedCapabilities.stack[ tail ];
+	item->trigger         = resultElem->trigger;
+	item->state           = record->state;
+	item->stateType       = record->stateType;
+	item->capabilityIndex = guide->index;
+	item->args            = &guide->args;
+	item->trace           = resultElem->trace;
+	macroResultDelayedIndex[ insert ] = tail + 1;
+
+	// Publish to the consumer
+	__atomic_store_n( &macroResultDelayedCapabilities.tail, next, __ATOMIC_RELEASE );
+}
+
+
 void Result_evalResultMacroCombo(
 	ResultPendingElem *resultElem,
 	const ResultMacro *macro,
@@ -146,57 +259,91 @@ void Result_evalResultMacroCombo(
 			capability( resultElem->trigger, record->state, record->stateType, &guide->args );
 		}
 		// Otherwise, queue up the capability for later
-		else if ( macroResultDelayedCapabilities.size < ResultCapabilityStackSize_define )
+		else
+		{
+			Result_queueDelayed( resultElem, record, guide );
+		}
+
+		// Increment counters
+		funcCount++;
+		*comboItem += ResultGuideSize( (ResultGuide*)(&macro->guide[ *comboItem ]) );
+	}
+}
+
+
+// Index the TriggerEvent buffer by (TriggerType, index)
+// Only the first event of each (TriggerType, index) pair is indexed
+// Must be called after the TriggerEvent buffer is finalized for the processing loop
+void Result_indexTriggerEvents()
+{
+	// Clear the slots used by the previous rebuild
+	for ( var_uint_t used = 0; used < macroTriggerEventIndexUsedSize; used++ )
+	{
+		macroTriggerEventIndex[ macroTriggerEventIndexUsed[ used ] ] = 0;
+	}
+	macroTriggerEventIndexUsedSize = 0;
+
+	for ( var_uint_t pos = 0; pos < macroTriggerEventBufferSize; pos++ )
+	{
+		TriggerEvent *event = &macroTriggerEventBuffer[ pos ];
+		uint16_t slot = ( ( event->type << 8 ) | event->index ) % ResultEventIndexSize;
+
+		// Linear probe until an empty slot, or the same (TriggerType, index) pair, is found
+		for ( uint16_t probe = 0; probe < ResultEventIndexSize; probe++ )
 		{
-			// Make sure we haven't already added this exact capability (with same state)
-			uint8_t size = macroResultDelayedCapabilities.size;
-			uint8_t pos = 0;
-			for ( ; pos < size; pos++ )
+			uint16_t cur = macroTriggerEventIndex[ slot ];
+			if ( cur == 0 )
+			{
+				macroTriggerEventIndex[ slot ] = pos + 1;
+				macroTriggerEventIndexUsed[ macroTriggerEventIndexUsedSize++ ] = slot;
+				break;
+			}
+
+			// Already indexed, keep the first event
+			TriggerEvent *cur_event = &macroTriggerEventBuffer[ cur - 1 ];
+			if ( cur_event->type == event->type && cur_event->index == event->index )
 			{
-				volatile ResultCapabilityStackItem *item = &macroResultDelayedCapabilities.stack[ pos ];
-				// Check each of the conditions
-				if (
-					item->trigger == resultElem->trigger &&
-					item->state == record->state &&
-					item->stateType == record->stateType &&
-					item->capabilityIndex == guide->index
-				)
-				{
-					// Check args to make sure it's not a NULL pointer first
-					if ( guide->args != 0 && item->args == &guide->args )
-					{
-						// Don't add
-						continue;
-					}
-					else if ( guide->args == 0 )
-					{
-						// Don't add
-						continue;
-					}
-				}
+				break;
 			}
 
-			// Only add if we've gone through the entire list and not found a match
-			if ( pos >= size )
+			if ( ++slot >= ResultEventIndexSize )
 			{
-				volatile ResultCapabilityStackItem *item = &macroResultDelayedCapabilities.stack[ size ];
-				item->trigger         = resultElem->trigger;
-				item->state           = record->state;
-				item->stateType       = record->stateType;
-				item->capabilityIndex = guide->index;
-				item->args            = &guide->args;
-				macroResultDelayedCapabilities.size++;
+				slot = 0;
 			}
 		}
-		else
+	}
+}
+
+
+// Lookup first TriggerEvent in the buffer matching the TriggerType and index
+// Returns 0 if not found
+TriggerEvent *Result_lookupTriggerEvent( uint8_t type, uint8_t index )
+{
+	uint16_t slot = ( ( type << 8 ) | index ) % ResultEventIndexSize;
+
+	for ( uint16_t probe = 0; probe < ResultEventIndexSize; probe++ )
+	{
+		uint16_t cur = macroTriggerEventIndex[ slot ];
+
+		// Empty slot, not found
+		if ( cur == 0 )
 		{
-			warn_printNL("Delayed capability stack full!");
+			return 0;
 		}
 
-		// Increment counters
-		funcCount++;
-		*comboItem += ResultGuideSize( (ResultGuide*)(&macro->guide[ *comboItem ]) );
+		TriggerEvent *event = &macroTriggerEventBuffer[ cur - 1 ];
+		if ( event->type == type && event->index == index )
+		{
+			return event;
+		}
+
+		if ( ++slot >= ResultEventIndexSize )
+		{
+			slot = 0;
+		}
 	}
+
+	return 0;
 }
 
 
@@ -215,15 +362,8 @@ void Result_appendResultMacroToPendingList( const TriggerMacro *triggerMacro )
 
 	// Lookup index and type of a key in the last combo
 	// Depending on the trigger type, which key selected will vary
-	// First, find the last combo
-	var_uint_t prev_pos = 0;
-	var_uint_t pos = 0;
-	for ( uint8_t comboLength = triggerMacro->guide[0]; comboLength > 0; )
-	{
-		prev_pos = pos;
-		pos += TriggerGuideSize * comboLength + 1;
-		comboLength = triggerMacro->guide[ pos ];
-	}
+	// Last combo position is computed during setup
+	var_uint_t prev_pos = resultTriggerMacroLastCombo[ triggerMacro - TriggerMacroList ];
 
 	// Parse the guide and scan each of the keys of the selected combo
 	TriggerEvent *event = 0;
@@ -231,21 +371,9 @@ void Result_appendResultMacroToPendingList( const TriggerMacro *triggerMacro )
 	{
 		// Calculate position of next TriggerGuide
 		TriggerGuide *cur_guide = (TriggerGuide*)&triggerMacro->guide[prev_pos + 1 + elem * TriggerGuideSize];
-		TriggerEvent *cur_event = 0;
 
-		// Lookup index in buffer list for the current state and stateType
-		for ( var_uint_t keyIndex = 0; keyIndex < macroTriggerEventBufferSize; keyIndex++ )
-		{
-			if (
-				macroTriggerEventBuffer[ keyIndex ].index == cur_guide->scanCode &&
-				macroTriggerEventBuffer[ keyIndex ].type == cur_guide->type
-			)
-			{
-				cur_event = &macroTriggerEventBuffer[ keyIndex ];
-				break;
-			}
-
-		}
+		// Lookup event in buffer for the current state and stateType
+		TriggerEvent *cur_event = Result_lookupTriggerEvent( cur_guide->type, cur_guide->scanCode );
 
 		// Make sure an event was found...(this is unlikely)
 		if ( cur_event == 0 )
@@ -332,6 +460,9 @@ void Result_appendResultMacroToPendingList( const TriggerMacro *triggerMacro )
 	elem->record.state     = event->state;
 	elem->record.stateType = event->type;
 
+	// Associate with the traced key event (if any)
+	elem->trace = Trace_lookup( event->type, event->index, event->state );
+
 	// If this is a Layer stateType, mask the Shift/Latch/Lock information
 	switch ( elem->record.stateType )
 	{
@@ -410,8 +541,30 @@ void Result_setup()
 	// Initialize macroResultMacroPendingList
 	macroResultMacroPendingList.size = 0;
 
-	// Reset delayed capabilities stack
-	macroResultDelayedCapabilities.size = 0;
+	// Clear trigger event index
+	memset( macroTriggerEventIndex, 0, sizeof( macroTriggerEventIndex ) );
+	macroTriggerEventIndexUsedSize = 0;
+
+	// Reset delayed capabilities ring
+	macroResultDelayedCapabilities.head = 0;
+	macroResultDelayedCapabilities.tail = 0;
+	memset( macroResultDelayedIndex, 0, sizeof( macroResultDelayedIndex ) );
+	macroResultDelayedActive = 0;
+
+	// Find the last combo of each TriggerMacro
+	for ( var_uint_t macro = 0; macro < TriggerMacroNum_KLL; macro++ )
+	{
+		const TriggerMacro *triggerMacro = &TriggerMacroList[ macro ];
+		var_uint_t prev_pos = 0;
+		var_uint_t pos = 0;
+		for ( uint8_t comboLength = triggerMacro->guide[0]; comboLength > 0; )
+		{
+			prev_pos = pos;
+			pos += TriggerGuideSize * comboLength + 1;
+			comboLength = triggerMacro->guide[ pos ];
+		}
+		resultTriggerMacroLastCombo[ macro ] = prev_pos;
+	}
 
 	// Capability debug mode
 	capDebugMode = 0;
@@ -421,22 +574,24 @@ void Result_setup()
 // Process delayed capabilities
 // Capabilities that are not called immediately (i.e. ones that are not deemed as thread safe)
 // are processed with this function
+// The periodic timer keeps running (scanning continues), only Macro_periodic is held off while a capability runs
 void Result_process_delayed()
 {
-	// Disable periodic interrupts if we have delayed capabilities
-	Periodic_disable();
+	uint8_t head = macroResultDelayedCapabilities.head;
 
-	// Process stack until empty
-	// For each empty, make sure interrupts are disabled
-	while ( macroResultDelayedCapabilities.size > 0 )
+	// Process ring until empty
+	while ( head != __atomic_load_n( &macroResultDelayedCapabilities.tail, __ATOMIC_ACQUIRE ) )
 	{
-		// Lookup stack
-		volatile ResultCapabilityStackItem *item = &macroResultDelayedCapabilities.stack[macroResultDelayedCapabilities.size - 1];
+		// Lookup ring
+		ResultCapabilityStackItem *item = &macroResultDelayedCapabilities.stack[ head ];
 
 		// Do lookup on capability function
 		void (*capability)(TriggerMacro*, uint8_t, uint8_t, uint8_t*) = \
 			(void(*)(TriggerMacro*, uint8_t, uint8_t, uint8_t*))(CapabilitiesList[ item->capabilityIndex ].func);
 
+		// Hold off Macro_periodic
+		__atomic_store_n( &macroResultDelayedActive, 1, __ATOMIC_SEQ_CST );
+
 		// Capability debug
 		if ( capDebugMode )
 		{
@@ -457,14 +612,16 @@ void Result_process_delayed()
 #endif
 
 		// Call capability
+		Trace_current = item->trace;
 		capability( item->trigger, item->state, item->stateType, item->args );
+		Trace_current = 0;
 
-		// Decrease stack size
-		macroResultDelayedCapabilities.size--;
-	}
+		__atomic_store_n( &macroResultDelayedActive, 0, __ATOMIC_SEQ_CST );
 
-	// Re-enable periodic interrupts
-	Periodic_enable();
+		// Release slot to the producer
+		head = head + 1 >= ResultDelayedRingSize ? 0 : head + 1;
+		__atomic_store_n( &macroResultDelayedCapabilities.head, head, __ATOMIC_RELEASE );
+	}
 }
 
 
@@ -477,6 +634,9 @@ void Result_process()
 	// Iterate through the pending ResultMacros, processing each of them
 	for ( index_uint_t macro = 0; macro < macroResultMacroPendingList.size; macro++ )
 	{
+		// Capabilities called by the ResultMacro are attributed to the traced key event
+		Trace_current = macroResultMacroPendingList.data[ macro ].trace;
+
 		switch ( Result_evalResultMacro( &macroResultMacroPendingList.data[ macro ] ) )
 		{
 		// Re-add macros to pending list
@@ -494,6 +654,8 @@ void Result_process()
 		}
 	}
 
+	Trace_current = 0;
+
 	// Update the macroResultMacroPendingListSize with the tail pointer
 	macroResultMacroPendingList.size = macroResultMacroPendingListTail;
 }
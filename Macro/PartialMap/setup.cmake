@@ -16,6 +16,7 @@ set ( Module_SRCS
 	layer.c
 	macro.c
 	result.c
+	trace.c
 	trigger.c
 )
 
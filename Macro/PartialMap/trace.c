@@ -0,0 +1,244 @@
+/* Copyright (C) 2021 by Jacob Alexander
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// ----- Includes -----
+
+// Compiler Includes
+#include <Lib/MacroLib.h>
+
+// Project Includes
+#include <latency.h>
+#include <print.h>
+
+// Local Includes
+#include "trace.h"
+#include "kll.h"
+
+
+
+// ----- Defines -----
+
+// Number of traced events that may be part of a single USB report
+#define TracePendingSize 8
+
+#if LatencyTrace_define == 1 && ( LatencyTraceSize_define < 1 || LatencyTraceSize_define > 255 )
+#error "LatencyTraceSize must be between 1 and 255"
+#endif
+
+
+
+// ----- Variables -----
+
+#if LatencyTrace_define == 1
+// Ring buffer of the most recent key events, indexed by event id
+static TraceRecord traceRecords[ LatencyTraceSize_define ];
+
+// Most recent event id
+static uint16_t traceLastId;
+
+// Events that have modified the USB report, but have not been sent yet
+static uint16_t tracePending[ TracePendingSize ];
+static uint8_t tracePendingSize;
+
+// End-to-end latency resource
+static uint8_t traceLatencyResource;
+#endif
+
+// Event id of the result macro currently being processed (0 if none)
+//  * Set by the result macro processing, read by the capabilities that modify the USB report
+uint16_t Trace_current;
+
+
+
+// ----- Functions -----
+
+void Trace_setup()
+{
+	Trace_current = 0;
+
+#if LatencyTrace_define == 1
+	memset( traceRecords, 0, sizeof( traceRecords ) );
+	traceLastId = 0;
+	tracePendingSize = 0;
+
+	// Key transition to USB report latency
+	traceLatencyResource = Latency_add_resource("KeyToUSB", LatencyOption_us);
+#endif
+}
+
+
+// Start tracing a debounced key transition
+// Only Switch Press and Release events are traced
+//
+// Returns event id, 0 if not traced
+uint16_t Trace_keyEvent( uint8_t type, uint8_t index, uint8_t state )
+{
+#if LatencyTrace_define == 1
+	switch ( type )
+	{
+	case TriggerType_Switch1:
+	case TriggerType_Switch2:
+	case TriggerType_Switch3:
+	case TriggerType_Switch4:
+		break;
+	default:
+		return 0;
+	}
+
+	if ( state != ScheduleType_P && state != ScheduleType_R )
+	{
+		return 0;
+	}
+
+	// Next id, 0 is reserved
+	if ( ++traceLastId == 0 )
+	{
+		traceLastId = 1;
+	}
+
+	TraceRecord *record = &traceRecords[ traceLastId % LatencyTraceSize_define ];
+	record->id      = traceLastId;
+	record->type    = type;
+	record->index   = index;
+	record->state   = state;
+	record->sent    = 0;
+	record->start   = Time_now();
+	record->latency = 0;
+
+	return traceLastId;
+#else
+	return 0;
+#endif
+}
+
+
+// Lookup the most recent unsent event matching the TriggerEvent
+// Events are generally looked up in the same processing loop they were added
+//
+// Returns event id, 0 if not found
+uint16_t Trace_lookup( uint8_t type, uint8_t index, uint8_t state )
+{
+#if LatencyTrace_define == 1
+	if ( state != ScheduleType_P && state != ScheduleType_R )
+	{
+		return 0;
+	}
+
+	// Search from newest to oldest
+	uint16_t id = traceLastId;
+	for ( uint8_t pos = 0; pos < LatencyTraceSize_define; pos++, id-- )
+	{
+		TraceRecord *record = &traceRecords[ id % LatencyTraceSize_define ];
+		if ( record->id != id )
+		{
+			break;
+		}
+
+		if ( !record->sent && record->type == type && record->index == index && record->state == state )
+		{
+			return id;
+		}
+	}
+#endif
+	return 0;
+}
+
+
+// Current event (Trace_current) has modified the USB report
+// Called by USB report capabilities
+void Trace_report()
+{
+#if LatencyTrace_define == 1
+	if ( Trace_current == 0 )
+	{
+		return;
+	}
+
+	// Check if already pending
+	for ( uint8_t pos = 0; pos < tracePendingSize; pos++ )
+	{
+		if ( tracePending[ pos ] == Trace_current )
+		{
+			return;
+		}
+	}
+
+	// Only the first events of a report are tracked if there are too many
+	if ( tracePendingSize < TracePendingSize )
+	{
+		tracePending[ tracePendingSize++ ] = Trace_current;
+	}
+#endif
+}
+
+
+// USB report was sent, record latency of each of the pending events
+// Called by the Output module after sending a keyboard report
+void Trace_reportSent()
+{
+#if LatencyTrace_define == 1
+	for ( uint8_t pos = 0; pos < tracePendingSize; pos++ )
+	{
+		uint16_t id = tracePending[ pos ];
+		TraceRecord *record = &traceRecords[ id % LatencyTraceSize_define ];
+
+		// Skip if the record was already overwritten
+		if ( record->id != id || record->sent )
+		{
+			continue;
+		}
+
+		record->latency = Time_duration_us( record->start );
+		record->sent = 1;
+		Latency_add_measurement( traceLatencyResource, record->latency );
+	}
+
+	tracePendingSize = 0;
+#endif
+}
+
+
+// Number of traced events available
+uint8_t Trace_records()
+{
+#if LatencyTrace_define == 1
+	return traceLastId < LatencyTraceSize_define ? traceLastId : LatencyTraceSize_define;
+#else
+	return 0;
+#endif
+}
+
+
+// Lookup traced event
+// pos - 0 is the most recent event
+//
+// Returns 0 if not available
+const TraceRecord *Trace_record( uint8_t pos )
+{
+#if LatencyTrace_define == 1
+	if ( pos >= Trace_records() )
+	{
+		return 0;
+	}
+
+	uint16_t id = traceLastId - pos;
+	TraceRecord *record = &traceRecords[ id % LatencyTraceSize_define ];
+	return record->id == id ? record : 0;
+#else
+	return 0;
+#endif
+}
+
@@ -0,0 +1,66 @@
+/* Copyright (C) 2021 by Jacob Alexander
+ *
+ * This file is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// ----- Includes -----
+
+// Compiler Includes
+#include <stdint.h>
+
+// KLL Generated Defines
+#include <kll_defs.h>
+
+// Project Includes
+#include <Lib/time.h>
+
+
+
+// ----- Structs -----
+
+// Key event trace record
+// Tracks a debounced key transition until the USB report containing it is sent
+typedef struct TraceRecord {
+	uint16_t id;      // Event id (sequence number), 0 is unused
+	uint8_t  type;    // TriggerType
+	uint8_t  index;   // TriggerEvent index (i.e. ScanCode)
+	uint8_t  state;   // ScheduleType (Press or Release)
+	uint8_t  sent;    // Set once the USB report was sent
+	Time     start;   // Time of the key transition
+	uint32_t latency; // Key transition to USB report latency (us)
+} TraceRecord;
+
+
+
+// ----- Variables -----
+
+extern uint16_t Trace_current;
+
+
+
+// ----- Functions -----
+
+void Trace_setup();
+
+uint16_t Trace_keyEvent( uint8_t type, uint8_t index, uint8_t state );
+uint16_t Trace_lookup( uint8_t type, uint8_t index, uint8_t state );
+
+void Trace_report();
+void Trace_reportSent();
+
+uint8_t Trace_records();
+const TraceRecord *Trace_record( uint8_t pos );
+
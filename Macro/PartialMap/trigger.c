@@ -86,11 +86,22 @@ extern uint8_t voteDebugMode;
 index_uint_t macroTriggerMacroPendingList[ TriggerMacroNum ] = { 0 };
 index_uint_t macroTriggerMacroPendingListSize = 0;
 
+// Pending Trigger Macro Membership Bitfield
+//  * Bit is set if the trigger macro index is currently in macroTriggerMacroPendingList
+//  * Kept in sync with the pending list, used to skip duplicates without scanning the list
+uint8_t macroTriggerMacroPendingBits[ ( TriggerMacroNum + 7 ) / 8 ] = { 0 };
+
+// Pending Trigger Macro bitfield helpers
+#define Trigger_pendingBitTest( index )  ( macroTriggerMacroPendingBits[ (index) >> 3 ] & ( 1 << ( (index) & 0x7 ) ) )
+#define Trigger_pendingBitSet( index )   ( macroTriggerMacroPendingBits[ (index) >> 3 ] |= ( 1 << ( (index) & 0x7 ) ) )
+#define Trigger_pendingBitClear( index ) ( macroTriggerMacroPendingBits[ (index) >> 3 ] &= ~( 1 << ( (index) & 0x7 ) ) )
+
 
 
 // ----- Protected Macro Functions -----
 
 extern void Result_appendResultMacroToPendingList( const TriggerMacro *triggerMacro );
+extern void Result_indexTriggerEvents();
 
 
 
@@ -845,21 +856,12 @@ void Trigger_updateTriggerMacroPendingList()
 			// Lookup trigger macro index
 			var_uint_t triggerMacroIndex = triggerList[ macro ];
 
-			// Iterate over macroTriggerMacroPendingList to see if any macro in the scancode's
-			//  triggerList needs to be added
-			var_uint_t pending = 0;
-			for ( ; pending < macroTriggerMacroPendingListSize; pending++ )
-			{
-				// Stop scanning if the trigger macro index is found in the pending list
-				if ( macroTriggerMacroPendingList[ pending ] == triggerMacroIndex )
-					break;
-			}
-
-			// If the triggerMacroIndex (macro) was not found in the macroTriggerMacroPendingList
+			// If the triggerMacroIndex (macro) is not already in the macroTriggerMacroPendingList
 			// Add it to the list
-			if ( pending == macroTriggerMacroPendingListSize )
+			if ( !Trigger_pendingBitTest( triggerMacroIndex ) )
 			{
 				macroTriggerMacroPendingList[ macroTriggerMacroPendingListSize++ ] = triggerMacroIndex;
+				Trigger_pendingBitSet( triggerMacroIndex );
 
 				// Reset macro position
 				TriggerMacroRecordList[ triggerMacroIndex ].pos     = 0;
@@ -923,6 +925,10 @@ void Trigger_setup()
 		TriggerMacroRecordList[ macro ].prevPos = 0;
 		TriggerMacroRecordList[ macro ].state   = TriggerMacro_Waiting;
 	}
+
+	// Clear pending list
+	macroTriggerMacroPendingListSize = 0;
+	memset( macroTriggerMacroPendingBits, 0, sizeof( macroTriggerMacroPendingBits ) );
 }
 
 
@@ -931,6 +937,10 @@ void Trigger_process()
 	// Update pending trigger list, before processing TriggerMacros
 	Trigger_updateTriggerMacroPendingList();
 
+	// Index the TriggerEvent buffer for result macro scheduling
+	// No more events are added to the buffer for this processing loop
+	Result_indexTriggerEvents();
+
 	// Tail pointer for macroTriggerMacroPendingList
 	// Macros must be explicitly re-added
 	var_uint_t macroTriggerMacroPendingListTail = 0;
@@ -983,12 +993,13 @@ void Trigger_process()
 				&TriggerMacroList[ cur_macro ]
 			);
 
-		// Remove Macro from Pending List, nothing to do, removing by default
+		// Remove Macro from Pending List, only need to clear the pending bit
 		case TriggerMacroEval_Remove:
 			if ( voteDebugMode )
 			{
 				print(" R" NL);
 			}
+			Trigger_pendingBitClear( cur_macro );
 			break;
 		}
 	}
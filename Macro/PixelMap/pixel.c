@@ -94,6 +94,16 @@ typedef enum PixelFadeControl {
 	PixelFadeControl_LAST,
 } PixelFadeControl;
 
+// Compiled Animation Frame
+// Index into the compiled frame operation pool (see Pixel_pixelTweenCompiled)
+typedef struct PixelCompiledFrame {
+	const uint8_t *frame;     // Animation frame data, 0 if unused
+	uint16_t       start;     // First operation in Pixel_compiledOps
+	uint16_t       count;     // Number of operations
+	uint8_t        relative;  // Set if the frame uses relative addressing (depends on the trigger scancode)
+	uint8_t        scan_code; // Scancode used to resolve relative addressing
+} PixelCompiledFrame;
+
 
 
 // ----- Variables -----
@@ -192,6 +202,43 @@ static uint8_t Pixel_pixel_fade_profile[Pixel_TotalPixels_KLL];
 // TODO (HaaTa): Use KLL to determine number of profiles (currently only 4)
 static PixelFadeProfile Pixel_pixel_fade_profile_entries[4];
 
+// Dirty Channel Tracking
+// Channels modified since the last frame, only these are re-processed by Pixel_SecondaryProcessing
+static uint32_t Pixel_dirtyChannels[ ( Pixel_TotalChannels_KLL + 31 ) / 32 ];
+static uint8_t  Pixel_dirty;       // Set if any channel is dirty
+static uint8_t  Pixel_refreshAll;  // Re-process every channel on the next frame (e.g. fade or gamma settings changed)
+
+// Bitmask of fade profiles (profile 1 is bit 0) with a different output on the next frame
+static uint8_t Pixel_fadeProfileChanged;
+
+// Bitmask of fade profiles (profile 1 is bit 0) with an out of date lookup table
+static uint8_t Pixel_fadeLutStale;
+
+// Bitmask of LED_Buffers updated since the last Pixel_bufferChanges() call
+static uint32_t Pixel_bufferChanged;
+
+// Double Buffering
+// LED drivers may provide a second set of LED_Buffers (see Pixel_setBackBuffer)
+// The next frame is processed into the back buffers while the front buffers are being sent
+static void    *Pixel_backBuffers[Pixel_BuffersLen_KLL];
+static uint8_t  Pixel_doubleBuffered;
+static uint8_t  Pixel_overlapped;  // Set if the ready frame was processed while the previous frame was being sent
+static uint32_t Pixel_dirtyFront[ ( Pixel_TotalChannels_KLL + 31 ) / 32 ]; // Channels modified since the last swap
+static uint32_t Pixel_dirtyBack[ ( Pixel_TotalChannels_KLL + 31 ) / 32 ];  // Channels out of date in the back buffers
+
+// Output brightness, applied while writing the LED_Buffers (see Pixel_setOutputBrightness)
+// Lookup table is only used (and valid) when brightness is not 0xFF
+static uint8_t Pixel_outputBrightness = 0xFF;
+static uint8_t Pixel_outputLut[256];
+
+// Compiled Animation Frames
+// Frames are flattened into PixelOps the first time they are played, re-used afterwards
+// Hash table is keyed by frame data pointer, operations are allocated from a pool
+static PixelCompiledFrame Pixel_compiledFrames[Pixel_CompiledFramesSize];
+static PixelOp            Pixel_compiledOps[Pixel_CompiledOpsSize];
+static uint16_t           Pixel_compiledOpsUsed;
+static uint8_t            Pixel_compiledFull; // Set if a frame did not fit, cache is reset on the next animation add
+
 // Latency Measurement Resource
 static uint8_t pixelLatencyResource;
 
@@ -205,8 +252,10 @@ uint8_t Pixel_determineLastTriggerScanCode( TriggerMacro *trigger );
 
 void Pixel_pixelSet( PixelElement *elem, uint32_t value );
 void Pixel_clearAnimations();
+void Pixel_compiledReset();
 
 void Pixel_SecondaryProcessing_profile_init();
+static void Pixel_fadeSettingsChanged();
 
 PixelBuf *Pixel_bufferMap( uint16_t channel );
 
@@ -269,6 +318,9 @@ void Pixel_GammaControl_capability( TriggerMacro *trigger, uint8_t state, uint8_
 		gamma_enabled = !gamma_enabled;
 		break;
 	}
+
+	// Gamma applies to all pixels
+	Pixel_fadeSettingsChanged();
 }
 
 void Pixel_AnimationIndex_capability( TriggerMacro *trigger, uint8_t state, uint8_t stateType, uint8_t *args )
@@ -522,6 +574,7 @@ void Pixel_FadeSet_capability( TriggerMacro *trigger, uint8_t state, uint8_t sta
 	// Reset the current period being processed
 	Pixel_pixel_fade_profile_entries[profile].pos = 0;
 	Pixel_pixel_fade_profile_entries[profile].period_conf = PixelPeriodIndex_Off_to_On;
+	Pixel_fadeSettingsChanged();
 }
 
 void Pixel_FadeLayerHighlight_capability( TriggerMacro *trigger, uint8_t state, uint8_t stateType, uint8_t *args )
@@ -743,6 +796,9 @@ void Pixel_FadeControl_capability( TriggerMacro *trigger, uint8_t state, uint8_t
 		return;
 	}
 
+	// Re-process pixels with the updated profile settings
+	Pixel_fadeSettingsChanged();
+
 	// Process command
 	uint16_t tmp;
 	switch ( command )
@@ -872,6 +928,33 @@ uint8_t Pixel_8bitInterpolation( uint8_t start, uint8_t end, uint8_t dist )
 	return (start * (256 - dist) + end * dist) >> 8;
 }
 
+// Mark channel as modified, it will be re-processed on the next frame
+static inline void Pixel_channelDirty( uint16_t channel )
+{
+	if ( channel >= Pixel_TotalChannels_KLL )
+	{
+		return;
+	}
+
+	Pixel_dirtyChannels[ channel >> 5 ] |= 1UL << ( channel & 0x1F );
+	Pixel_dirty = 1;
+}
+
+// Read channel value, regardless of buffer width
+static inline uint32_t Pixel_channelValue( PixelBuf *pixbuf, uint16_t channel )
+{
+	switch ( pixbuf->width )
+	{
+	case 8:
+		return PixelBuf8( pixbuf, channel );
+	case 16:
+		return PixelBuf16( pixbuf, channel );
+	case 32:
+		return PixelBuf32( pixbuf, channel );
+	}
+	return 0;
+}
+
 void Pixel_pixelInterpolate( PixelElement *elem, uint8_t position, uint8_t intensity )
 {
 	// Toggle each of the channels of the pixel
@@ -881,6 +964,7 @@ void Pixel_pixelInterpolate( PixelElement *elem, uint8_t position, uint8_t inten
 		uint16_t ch_pos = elem->indices[ch];
 		PixelBuf *pixbuf = Pixel_bufferMap( ch_pos );
 		PixelBuf16( pixbuf, ch_pos ) = Pixel_8bitInterpolation( 0, intensity, position * (ch + 1) );
+		Pixel_channelDirty( ch_pos );
 	}
 }
 
@@ -909,6 +993,12 @@ uint8_t Pixel_addDefaultAnimation( uint32_t index )
 // Returns 1 on success, 0 on failure to allocate
 uint8_t Pixel_addAnimation( AnimationStackElement *element, CapabilityState cstate )
 {
+	// Make room for the new animation if previous frames filled the compiled frame cache
+	if ( Pixel_compiledFull )
+	{
+		Pixel_compiledReset();
+	}
+
 	AnimationStackElement *found;
 	switch ( element->replace )
 	{
@@ -1100,6 +1190,17 @@ void Pixel_clearAnimations()
 	{
 		Pixel_AnimationElement_Stor[pos].index = 0xFFFF;
 	}
+
+	// Compiled frames are no longer needed
+	Pixel_compiledReset();
+}
+
+// Clears the compiled animation frame cache
+void Pixel_compiledReset()
+{
+	memset( Pixel_compiledFrames, 0, sizeof( Pixel_compiledFrames ) );
+	Pixel_compiledOpsUsed = 0;
+	Pixel_compiledFull = 0;
 }
 
 // Clears all pixels
@@ -1260,24 +1361,21 @@ PixelBuf *LED_bufferMap( uint16_t channel )
 		break; \
 	}
 
-// Pixel Evaluation
-// - Iterates over each of the Pixel channels and applies modifications
-void Pixel_pixelEvaluation( PixelModElement *mod, PixelElement *elem )
+// Pixel Decode
+// - Decodes the modification of each of the Pixel channels into PixelOps
+// - Channel buffer location is resolved during decoding
+// - Returns the number of PixelOps (stops at the first invalid channel)
+static uint8_t Pixel_pixelDecode( PixelModElement *mod, PixelElement *elem, PixelOp *ops )
 {
-	// Ignore if no element
-	if ( elem == 0 )
-	{
-		return;
-	}
-
 	// Lookup number of channels in pixel
 	uint8_t channels = elem->channels;
 
 	// Data position iterator
 	uint8_t position_iter = 0;
 
-	// Apply operation to each channel of the pixel
-	for ( uint8_t ch = 0; ch < channels; ch++ )
+	// Decode each channel of the pixel
+	uint8_t ch = 0;
+	for ( ; ch < channels; ch++ )
 	{
 		// Lookup channel position
 		uint16_t ch_pos = elem->indices[ch];
@@ -1291,27 +1389,28 @@ void Pixel_pixelEvaluation( PixelModElement *mod, PixelElement *elem )
 			break;
 		}
 
-		// Change Type (first 8 bits of each channel of data, see pixel.h for layout)
-		PixelChange change = (PixelChange)mod->data[ position_iter++ ];
+		PixelOp *op = &ops[ch];
+		op->buffer = pixbuf - Pixel_Buffers;
+		op->offset = ch_pos - pixbuf->offset;
 
-		// Modification Value
-		uint32_t mod_value = 0;
+		// Change Type (first 8 bits of each channel of data, see pixel.h for layout)
+		op->change = mod->data[ position_iter++ ];
 
 		// Lookup modification value
 		switch ( elem->width )
 		{
 		case 8:
-			mod_value = mod->data[ position_iter++ ];
+			op->value = mod->data[ position_iter++ ];
 			break;
 
 		case 16:
-			mod_value = mod->data[ position_iter + 1 ] |
+			op->value = mod->data[ position_iter + 1 ] |
 				( mod->data[ position_iter + 2 ] << 8 );
 			position_iter += 2;
 			break;
 
 		case 32:
-			mod_value = mod->data[ position_iter + 1 ] |
+			op->value = mod->data[ position_iter + 1 ] |
 				( mod->data[ position_iter + 2 ] << 8 ) |
 				( mod->data[ position_iter + 3 ] << 16 ) |
 				( mod->data[ position_iter + 4 ] << 24 );
@@ -1319,112 +1418,152 @@ void Pixel_pixelEvaluation( PixelModElement *mod, PixelElement *elem )
 			break;
 
 		default:
+			op->value = 0;
 			warn_printNL("Invalid PixelElement width mapping");
 			break;
 		}
+	}
 
-		// Operation
-		switch ( change )
-		{
-		case PixelChange_Set:             // =
-			PixelChange_Expansion( pixbuf, ch_pos, mod_value, = );
-			break;
+	return ch;
+}
 
-		case PixelChange_Add:             // +
-			PixelChange_Expansion( pixbuf, ch_pos, mod_value, += );
-			break;
+// Pixel Operation
+// - Applies a decoded modification to a channel
+static void Pixel_pixelOp( const PixelOp *op )
+{
+	PixelBuf *pixbuf = &Pixel_Buffers[ op->buffer ];
+	uint16_t ch_pos = op->offset + pixbuf->offset;
+	uint32_t mod_value = op->value;
 
-		case PixelChange_Subtract:        // -
-			PixelChange_Expansion( pixbuf, ch_pos, mod_value, -= );
-			break;
+	// Previous value, used to determine if the channel was modified
+	uint32_t prev_value = Pixel_channelValue( pixbuf, ch_pos );
 
-		case PixelChange_LeftShift:       // <<
-			PixelChange_Expansion( pixbuf, ch_pos, mod_value, <<= );
-			break;
+	// Operation
+	switch ( (PixelChange)op->change )
+	{
+	case PixelChange_Set:             // =
+		PixelChange_Expansion( pixbuf, ch_pos, mod_value, = );
+		break;
 
-		case PixelChange_RightShift:      // >>
-			PixelChange_Expansion( pixbuf, ch_pos, mod_value, >>= );
-			break;
+	case PixelChange_Add:             // +
+		PixelChange_Expansion( pixbuf, ch_pos, mod_value, += );
+		break;
 
-		case PixelChange_NoRoll_Add:      // +:
-			// Lookup buffer to data width mapping
-			switch ( pixbuf->width )
-			{
-			case 8:  //  8  bit mapping
-			{
-				uint8_t prev = PixelBuf8( pixbuf, ch_pos );
-				PixelBuf8( pixbuf, ch_pos ) += (uint8_t)mod_value;
-				if ( prev > PixelBuf8( pixbuf, ch_pos ) )
-					PixelBuf8( pixbuf, ch_pos ) = 0xFF;
-				break;
-			}
-			case 16: // 16  bit mapping
-			{
-				// TODO Fix for 16 on 8 bit (i.e. early K-Type)
-				//uint16_t prev = PixelBuf16( pixbuf, ch_pos );
-				PixelBuf16( pixbuf, ch_pos ) += (uint16_t)mod_value;
-				/*
-				if ( prev > PixelBuf16( pixbuf, ch_pos ) )
-					PixelBuf16( pixbuf, ch_pos ) = 0xFFFF;
-				*/
-				if ( 0xFF < PixelBuf16( pixbuf, ch_pos ) )
-					PixelBuf16( pixbuf, ch_pos ) = 0xFF;
-				break;
-			}
-			case 32: // 32  bit mapping
-			{
-				uint32_t prev = PixelBuf32( pixbuf, ch_pos );
-				PixelBuf32( pixbuf, ch_pos ) += (uint32_t)mod_value;
-				if ( prev > PixelBuf32( pixbuf, ch_pos ) )
-					PixelBuf32( pixbuf, ch_pos ) = 0xFFFFFFFF;
-				break;
-			}
+	case PixelChange_Subtract:        // -
+		PixelChange_Expansion( pixbuf, ch_pos, mod_value, -= );
+		break;
 
-			default:
-				warn_printNL("Invalid width mapping on set");
-				break;
-			}
+	case PixelChange_LeftShift:       // <<
+		PixelChange_Expansion( pixbuf, ch_pos, mod_value, <<= );
+		break;
+
+	case PixelChange_RightShift:      // >>
+		PixelChange_Expansion( pixbuf, ch_pos, mod_value, >>= );
+		break;
+
+	case PixelChange_NoRoll_Add:      // +:
+		// Lookup buffer to data width mapping
+		switch ( pixbuf->width )
+		{
+		case 8:  //  8  bit mapping
+		{
+			uint8_t prev = PixelBuf8( pixbuf, ch_pos );
+			PixelBuf8( pixbuf, ch_pos ) += (uint8_t)mod_value;
+			if ( prev > PixelBuf8( pixbuf, ch_pos ) )
+				PixelBuf8( pixbuf, ch_pos ) = 0xFF;
 			break;
+		}
+		case 16: // 16  bit mapping
+		{
+			// TODO Fix for 16 on 8 bit (i.e. early K-Type)
+			//uint16_t prev = PixelBuf16( pixbuf, ch_pos );
+			PixelBuf16( pixbuf, ch_pos ) += (uint16_t)mod_value;
+			/*
+			if ( prev > PixelBuf16( pixbuf, ch_pos ) )
+				PixelBuf16( pixbuf, ch_pos ) = 0xFFFF;
+			*/
+			if ( 0xFF < PixelBuf16( pixbuf, ch_pos ) )
+				PixelBuf16( pixbuf, ch_pos ) = 0xFF;
+			break;
+		}
+		case 32: // 32  bit mapping
+		{
+			uint32_t prev = PixelBuf32( pixbuf, ch_pos );
+			PixelBuf32( pixbuf, ch_pos ) += (uint32_t)mod_value;
+			if ( prev > PixelBuf32( pixbuf, ch_pos ) )
+				PixelBuf32( pixbuf, ch_pos ) = 0xFFFFFFFF;
+			break;
+		}
 
-		case PixelChange_NoRoll_Subtract: // -:
-			// Lookup buffer to data width mapping
-			switch ( pixbuf->width )
-			{
-			case 8:  //  8  bit mapping
-			{
-				uint8_t prev = PixelBuf8( pixbuf, ch_pos );
-				PixelBuf8( pixbuf, ch_pos ) -= (uint8_t)mod_value;
-				if ( prev < PixelBuf8( pixbuf, ch_pos ) )
-					PixelBuf8( pixbuf, ch_pos ) = 0;
-				break;
-			}
-			case 16: // 16  bit mapping
-			{
-				uint16_t prev = PixelBuf16( pixbuf, ch_pos );
-				PixelBuf16( pixbuf, ch_pos ) -= (uint16_t)mod_value;
-				if ( prev < PixelBuf16( pixbuf, ch_pos ) )
-					PixelBuf16( pixbuf, ch_pos ) = 0;
-				break;
-			}
-			case 32: // 32  bit mapping
-			{
-				uint32_t prev = PixelBuf32( pixbuf, ch_pos );
-				PixelBuf32( pixbuf, ch_pos ) -= (uint32_t)mod_value;
-				if ( prev < PixelBuf32( pixbuf, ch_pos ) )
-					PixelBuf32( pixbuf, ch_pos ) = 0;
-				break;
-			}
+		default:
+			warn_printNL("Invalid width mapping on set");
+			break;
+		}
+		break;
 
-			default:
-				warn_printNL("Invalid width mapping on set");
-				break;
-			}
+	case PixelChange_NoRoll_Subtract: // -:
+		// Lookup buffer to data width mapping
+		switch ( pixbuf->width )
+		{
+		case 8:  //  8  bit mapping
+		{
+			uint8_t prev = PixelBuf8( pixbuf, ch_pos );
+			PixelBuf8( pixbuf, ch_pos ) -= (uint8_t)mod_value;
+			if ( prev < PixelBuf8( pixbuf, ch_pos ) )
+				PixelBuf8( pixbuf, ch_pos ) = 0;
+			break;
+		}
+		case 16: // 16  bit mapping
+		{
+			uint16_t prev = PixelBuf16( pixbuf, ch_pos );
+			PixelBuf16( pixbuf, ch_pos ) -= (uint16_t)mod_value;
+			if ( prev < PixelBuf16( pixbuf, ch_pos ) )
+				PixelBuf16( pixbuf, ch_pos ) = 0;
+			break;
+		}
+		case 32: // 32  bit mapping
+		{
+			uint32_t prev = PixelBuf32( pixbuf, ch_pos );
+			PixelBuf32( pixbuf, ch_pos ) -= (uint32_t)mod_value;
+			if ( prev < PixelBuf32( pixbuf, ch_pos ) )
+				PixelBuf32( pixbuf, ch_pos ) = 0;
 			break;
+		}
 
 		default:
-			warn_printNL("Unimplemented pixel modifier");
+			warn_printNL("Invalid width mapping on set");
 			break;
 		}
+		break;
+
+	default:
+		warn_printNL("Unimplemented pixel modifier");
+		break;
+	}
+
+	// Only mark modified channels, animations often re-set the same values every frame
+	if ( Pixel_channelValue( pixbuf, ch_pos ) != prev_value )
+	{
+		Pixel_channelDirty( ch_pos );
+	}
+}
+
+// Pixel Evaluation
+// - Iterates over each of the Pixel channels and applies modifications
+void Pixel_pixelEvaluation( PixelModElement *mod, PixelElement *elem )
+{
+	// Ignore if no element
+	if ( elem == 0 )
+	{
+		return;
+	}
+
+	// Decode, then apply operation to each channel of the pixel
+	PixelOp ops[Pixel_MaxChannelPerPixel];
+	uint8_t count = Pixel_pixelDecode( mod, elem, ops );
+	for ( uint8_t op = 0; op < count; op++ )
+	{
+		Pixel_pixelOp( &ops[op] );
 	}
 }
 
@@ -1770,6 +1909,135 @@ void Pixel_pixelTweenStandard( const uint8_t *frame, AnimationStackElement *stac
 	}
 }
 
+// Compile Animation Frame
+// - Resolves every pixel modifier element (fills, scancodes, etc.) into a flat list of PixelOps
+// - Operations are in the same order Pixel_pixelTweenStandard would apply them
+// - Returns 0 if the frame does not fit in the operation pool
+static uint8_t Pixel_pixelTweenCompile( const uint8_t *frame, AnimationStackElement *stack_elem, PixelCompiledFrame *compiled )
+{
+	uint16_t used = Pixel_compiledOpsUsed;
+	uint8_t relative = 0;
+
+	// Iterate over all of the Pixel Modifier elements of the Animation Frame
+	uint16_t pos = 0;
+	PixelModElement *mod = (PixelModElement*)&frame[pos];
+	while ( mod->type != PixelAddressType_End )
+	{
+		switch ( mod->type )
+		{
+		case PixelAddressType_RelativeIndex:
+		case PixelAddressType_RelativeRect:
+		case PixelAddressType_RelativeColumnFill:
+		case PixelAddressType_RelativeRowFill:
+			relative = 1;
+			break;
+		default:
+			break;
+		}
+
+		// Lookup type of pixel, choose fill algorith and query all sub-pixels
+		uint16_t next = 0;
+		uint16_t valid = 0;
+		PixelElement *prev_pixel_elem = 0;
+		PixelElement *elem = 0;
+		do {
+			// Last element
+			prev_pixel_elem = elem;
+
+			// Lookup pixel, and check if there are any more pixels left
+			next = Pixel_fillPixelLookup( mod, &elem, next, stack_elem, &valid );
+
+			// Decode operations for the pixel
+			if ( elem != 0 )
+			{
+				// Out of space
+				if ( used + elem->channels > Pixel_CompiledOpsSize )
+				{
+					return 0;
+				}
+
+				used += Pixel_pixelDecode( mod, elem, &Pixel_compiledOps[used] );
+			}
+		} while ( next );
+
+		// Determine next position
+		pos += Pixel_pixelTweenNextPos( elem, prev_pixel_elem );
+
+		// Lookup next mod element
+		mod = (PixelModElement*)&frame[pos];
+	}
+
+	compiled->frame = frame;
+	compiled->start = Pixel_compiledOpsUsed;
+	compiled->count = used - Pixel_compiledOpsUsed;
+	compiled->relative = relative;
+	compiled->scan_code = relative ? Pixel_determineLastTriggerScanCode( stack_elem->trigger ) : 0;
+	Pixel_compiledOpsUsed = used;
+	return 1;
+}
+
+// Compiled Pixel Pixel Function
+// - Same result as Pixel_pixelTweenStandard, but each frame is only resolved once
+// - Falls back to Pixel_pixelTweenStandard if the compiled frame cache is full
+void Pixel_pixelTweenCompiled( const uint8_t *frame, AnimationStackElement *stack_elem )
+{
+	// Lookup compiled frame, frames using relative addressing are compiled per trigger scancode
+	uint16_t hash = (uintptr_t)frame % Pixel_CompiledFramesSize;
+	uint16_t scan_code = 0xFFFF;
+	PixelCompiledFrame *compiled = 0;
+	for ( uint16_t probe = 0; probe < Pixel_CompiledFramesSize; probe++ )
+	{
+		PixelCompiledFrame *entry = &Pixel_compiledFrames[ ( hash + probe ) % Pixel_CompiledFramesSize ];
+
+		// Not compiled yet, use empty entry
+		if ( entry->frame == 0 )
+		{
+			if ( !Pixel_compiledFull && Pixel_pixelTweenCompile( frame, stack_elem, entry ) )
+			{
+				compiled = entry;
+			}
+			break;
+		}
+
+		if ( entry->frame != frame )
+		{
+			continue;
+		}
+
+		// Check relative scancode
+		if ( entry->relative )
+		{
+			if ( scan_code == 0xFFFF )
+			{
+				scan_code = Pixel_determineLastTriggerScanCode( stack_elem->trigger );
+			}
+			if ( entry->scan_code != scan_code )
+			{
+				continue;
+			}
+		}
+
+		compiled = entry;
+		break;
+	}
+
+	// Could not compile, evaluate frame directly
+	if ( compiled == 0 )
+	{
+		Pixel_compiledFull = 1;
+		Pixel_pixelTweenStandard( frame, stack_elem );
+		return;
+	}
+
+	// Stream through the operations
+	const PixelOp *op = &Pixel_compiledOps[ compiled->start ];
+	const PixelOp *end = op + compiled->count;
+	for ( ; op < end; op++ )
+	{
+		Pixel_pixelOp( op );
+	}
+}
+
 // Basic interpolation Pixel Pixel Function
 // TODO - Only works with Colummn and Row fill currently
 void Pixel_pixelTweenInterpolation( const uint8_t *frame, AnimationStackElement *stack_elem )
@@ -2039,7 +2307,7 @@ void Pixel_frameTweenStandard( const uint8_t *data, AnimationStackElement *elem
 	// Generic, no addition processing necessary
 	case PixelPixelFunction_Off:
 	case PixelPixelFunction_PointInterpolationKLL:
-		Pixel_pixelTweenStandard( data, elem );
+		Pixel_pixelTweenCompiled( data, elem );
 		break;
 	}
 }
@@ -2184,12 +2452,20 @@ void Pixel_channelSet( uint16_t channel, uint32_t value )
 
 	// 8bit width
 	case 8:
-		PixelBuf8( pixbuf, channel ) = (uint8_t)value;
+		if ( PixelBuf8( pixbuf, channel ) != (uint8_t)value )
+		{
+			PixelBuf8( pixbuf, channel ) = (uint8_t)value;
+			Pixel_channelDirty( channel );
+		}
 		break;
 
 	// 16bit width
 	case 16:
-		PixelBuf16( pixbuf, channel ) = (uint16_t)value;
+		if ( PixelBuf16( pixbuf, channel ) != (uint16_t)value )
+		{
+			PixelBuf16( pixbuf, channel ) = (uint16_t)value;
+			Pixel_channelDirty( channel );
+		}
 		break;
 	}
 }
@@ -2220,11 +2496,13 @@ void Pixel_channelToggle( uint16_t channel )
 	// 8bit width
 	case 8:
 		PixelBuf8( pixbuf, channel ) ^= 128;
+		Pixel_channelDirty( channel );
 		break;
 
 	// 16bit width
 	case 16:
 		PixelBuf16( pixbuf, channel ) ^= 128;
+		Pixel_channelDirty( channel );
 		break;
 	}
 }
@@ -2269,6 +2547,9 @@ void Pixel_SecondaryProcessing_profile_init()
 			Pixel_pixel_fade_profile[entry.pixels[pxin] - 1] = group + 1;
 		}
 	}
+
+	// Profile assignments have changed
+	Pixel_fadeSettingsChanged();
 }
 
 void Pixel_SecondaryProcessing_setup()
@@ -2317,19 +2598,329 @@ static inline uint32_t Pixel_ApplyFadeBrightness( uint8_t brightness, uint32_t v
 	return result;
 }
 
-void Pixel_SecondaryProcessing()
+// Returns and clears the bitmask of LED_Buffers updated since the last call
+// Used by LED drivers to only send the modified buffers
+uint32_t Pixel_bufferChanges()
+{
+	uint32_t changed = Pixel_bufferChanged;
+	Pixel_bufferChanged = 0;
+	return changed;
+}
+
+// Re-process and update every LED_Buffers channel on the next frame
+// Used by LED drivers when the contents of the LED_Buffers may have been lost
+void Pixel_bufferRefresh()
+{
+	Pixel_refreshAll = 1;
+}
+
+// Set output brightness of the LED_Buffers
+// Used by LED drivers without hardware brightness control, scaling is folded into the LED_Buffers update
+// Every channel is re-processed on the next frame if the brightness changed
+void Pixel_setOutputBrightness( uint8_t brightness )
+{
+	if ( brightness == Pixel_outputBrightness )
+	{
+		return;
+	}
+	Pixel_outputBrightness = brightness;
+
+	for ( uint16_t val = 0; val < 256; val++ )
+	{
+		Pixel_outputLut[val] = ( val * brightness ) / 0xFF;
+	}
+
+	Pixel_fadeSettingsChanged();
+}
+
+// Register the back buffer of the given LED_Buffers index, enables double buffering
+// Must be the same size and width as the LED_Buffers entry
+void Pixel_setBackBuffer( uint8_t buf, void *data )
 {
-	// Copy KLL buffer into LED buffer
+	if ( buf >= Pixel_BuffersLen_KLL )
+	{
+		erro_printNL("Invalid LED_Buffers index");
+		return;
+	}
+
+	Pixel_backBuffers[buf] = data;
+	Pixel_doubleBuffered = 1;
+
+	// Contents of the back buffer are unknown
+	Pixel_refreshAll = 1;
+}
+
+// Swap the front and back LED_Buffers, called by the LED driver before sending a ready frame
+// The LED_Buffers then point to the back buffers, the previous LED_Buffers must be sent
+// Returns 1 if the buffers were swapped (double buffering enabled)
+uint8_t Pixel_frameSwap()
+{
+	Pixel_FrameState = FrameState_Sending;
+
+	if ( !Pixel_doubleBuffered )
+	{
+		return 0;
+	}
+
 	for ( uint8_t buf = 0; buf < Pixel_BuffersLen_KLL; buf++ )
 	{
-		memcpy(
-			LED_Buffers[buf].data,
-			Pixel_Buffers[buf].data,
-			Pixel_Buffers[buf].size * ( Pixel_Buffers[buf].width >> 3 ) // Size may not be multiples bytes
-		);
+		// No back buffer registered
+		if ( Pixel_backBuffers[buf] == NULL )
+		{
+			continue;
+		}
+
+		void *data = LED_Buffers[buf].data;
+		LED_Buffers[buf].data = Pixel_backBuffers[buf];
+		Pixel_backBuffers[buf] = data;
+	}
+
+	// Channels modified since the last swap are out of date in the new back buffers
+	for ( uint16_t word = 0; word < sizeof( Pixel_dirtyFront ) / sizeof( uint32_t ); word++ )
+	{
+		Pixel_dirtyBack[ word ] |= Pixel_dirtyFront[ word ];
+		Pixel_dirtyFront[ word ] = 0;
+	}
+
+	return 1;
+}
+
+// Called by the LED driver once the frame has been sent (may be called from an interrupt)
+// Queued frames are ready to send immediately
+void Pixel_frameSent()
+{
+	Pixel_FrameState = Pixel_FrameState == FrameState_Queued
+		? FrameState_Ready
+		: FrameState_Update;
+}
+
+// Returns 1 if the ready frame was processed while the previous frame was being sent
+uint8_t Pixel_frameOverlapped()
+{
+	return Pixel_overlapped;
+}
+
+// Fade or gamma settings changed
+// Regenerate the fade lookup tables and re-process every channel on the next frame
+static void Pixel_fadeSettingsChanged()
+{
+	Pixel_fadeLutStale = 0x0F;
+	Pixel_refreshAll = 1;
+}
+
+// Calculate the faded value of a channel using the current profile state
+// Brightness, then gamma correction, then the position within the current fade period, then output brightness
+// Used to generate the fade lookup table (see Pixel_fadeLookup)
+uint8_t Pixel_fadeValue( uint8_t profile_in, uint8_t val )
+{
+	PixelFadeProfile *profile = &Pixel_pixel_fade_profile_entries[profile_in];
+	PixelPeriodConfig *period = &profile->conf[profile->period_conf];
+
+	uint32_t result = Pixel_ApplyFadeBrightness( profile->brightness, val );
+	if ( gamma_enabled )
+	{
+		result = gamma_table[result];
+	}
+
+	// Percentage calculation using 32-bit integer instead of float
+	// This is just a: pos / end * current value of LED
+	// Ignores rounding
+	// For 8-bit values, the maximum percentage spread must be no greater than 25-bits
+	// e.g. 1 << 24
+	switch ( profile->period_conf )
+	{
+	// Off -> On
+	case PixelPeriodIndex_Off_to_On:
+	// On -> Off
+	case PixelPeriodIndex_On_to_Off:
+		// If start and end are set to 0, ignore
+		if ( period->end == 0 && period->start == 0 )
+		{
+			break;
+		}
+
+		result *= profile->pos;
+		result >>= period->end;
+		break;
+
+	// On hold time
+	case PixelPeriodIndex_On:
+		break;
+
+	// Off hold time
+	case PixelPeriodIndex_Off:
+	{
+		PixelPeriodConfig *prev = &profile->conf[PixelPeriodIndex_On_to_Off];
+
+		// If the previous config was disabled, do not set to 0
+		if ( prev->start == 0 && prev->end == 0 )
+		{
+			break;
+		}
+
+		// If the previous On->Off change didn't go to fully off
+		// Calculate the value based off the previous config
+		if ( prev->start == 0 )
+		{
+			result = 0;
+			break;
+		}
+
+		result *= (1 << prev->start) - 1;
+		result >>= prev->end;
+		break;
+	}
 	}
 
-	// Iterate over each of the pixels, applying the appropriate profile to each one
+	// Output brightness
+	if ( Pixel_outputBrightness != 0xFF )
+	{
+		result = Pixel_outputLut[(uint8_t)result];
+	}
+
+	return (uint8_t)result;
+}
+
+// Regenerate the fade lookup table of the given profile (0 indexed)
+static void Pixel_fadeLutUpdate( uint8_t profile_in )
+{
+	uint8_t *lut = Pixel_pixel_fade_profile_entries[profile_in].lut;
+	for ( uint16_t val = 0; val < 256; val++ )
+	{
+		lut[val] = Pixel_fadeValue( profile_in, val );
+	}
+
+	Pixel_fadeLutStale &= ~(1 << profile_in);
+}
+
+// Lookup the faded value of a channel using the given profile (0 indexed)
+// The lookup table is only regenerated when brightness, gamma or the fade position changes
+uint8_t Pixel_fadeLookup( uint8_t profile_in, uint8_t val )
+{
+	if ( Pixel_fadeLutStale & (1 << profile_in) )
+	{
+		Pixel_fadeLutUpdate( profile_in );
+	}
+
+	return Pixel_pixel_fade_profile_entries[profile_in].lut[val];
+}
+
+// Check if any of the channels of the pixel have been modified
+static inline uint8_t Pixel_pixelDirty( const PixelElement *elem )
+{
+	for ( uint8_t ch = 0; ch < elem->channels; ch++ )
+	{
+		uint16_t chan = elem->indices[ch];
+		if ( chan < Pixel_TotalChannels_KLL && Pixel_dirtyChannels[ chan >> 5 ] & ( 1UL << ( chan & 0x1F ) ) )
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void Pixel_SecondaryProcessing()
+{
+	// Re-process everything (settings changed)
+	if ( Pixel_refreshAll )
+	{
+		memset( Pixel_dirtyChannels, 0xFF, sizeof( Pixel_dirtyChannels ) );
+		Pixel_dirty = 1;
+		Pixel_refreshAll = 0;
+	}
+
+	// Pixels with an active fade must be re-processed even if the channels have not been modified
+	if ( Pixel_fadeProfileChanged )
+	{
+		for ( uint16_t pxin = 0; pxin < Pixel_TotalPixels_KLL; pxin++ )
+		{
+			uint8_t profile_in = Pixel_pixel_fade_profile[pxin];
+			if ( profile_in == 0 || !( Pixel_fadeProfileChanged & ( 1 << ( profile_in - 1 ) ) ) )
+			{
+				continue;
+			}
+
+			const PixelElement *elem = &Pixel_Mapping[pxin];
+			for ( uint8_t ch = 0; ch < elem->channels; ch++ )
+			{
+				Pixel_channelDirty( elem->indices[ch] );
+			}
+		}
+	}
+
+	// Double buffering
+	// Channels modified on the previous frames were written to the other set of buffers
+	if ( Pixel_doubleBuffered )
+	{
+		for ( uint16_t word = 0; word < sizeof( Pixel_dirtyChannels ) / sizeof( uint32_t ); word++ )
+		{
+			Pixel_dirtyFront[ word ] |= Pixel_dirtyChannels[ word ];
+			Pixel_dirtyChannels[ word ] |= Pixel_dirtyBack[ word ];
+			if ( Pixel_dirtyBack[ word ] )
+			{
+				Pixel_dirty = 1;
+				Pixel_dirtyBack[ word ] = 0;
+			}
+		}
+	}
+
+	// Nothing to update (i.e. static lighting)
+	if ( !Pixel_dirty )
+	{
+		goto pixel_profile_update;
+	}
+
+	// Copy modified channels of the KLL buffer into the LED buffer, applying output brightness
+	// Buffers are ordered by channel
+	uint8_t cur = 0;
+	for ( uint16_t word = 0; word < sizeof( Pixel_dirtyChannels ) / sizeof( uint32_t ); word++ )
+	{
+		uint32_t bits = Pixel_dirtyChannels[ word ];
+		while ( bits )
+		{
+			uint16_t chan = ( word << 5 ) + __builtin_ctz( bits );
+			bits &= bits - 1;
+
+			// Lookup buffer containing the channel
+			while ( cur < Pixel_BuffersLen_KLL && chan >= Pixel_Buffers[cur].offset + Pixel_Buffers[cur].size )
+			{
+				cur++;
+			}
+			if ( cur >= Pixel_BuffersLen_KLL || chan < Pixel_Buffers[cur].offset )
+			{
+				continue;
+			}
+
+			Pixel_bufferChanged |= 1UL << cur;
+
+			// Output brightness (only the lower 8 bits of each channel are used)
+			if ( Pixel_outputBrightness != 0xFF )
+			{
+				uint16_t pos = chan - Pixel_Buffers[cur].offset;
+				switch ( Pixel_Buffers[cur].width )
+				{
+				case 8:
+					((uint8_t*)LED_Buffers[cur].data)[pos] = Pixel_outputLut[ ((uint8_t*)Pixel_Buffers[cur].data)[pos] ];
+					continue;
+
+				case 16:
+					((uint16_t*)LED_Buffers[cur].data)[pos] = Pixel_outputLut[ (uint8_t)((uint16_t*)Pixel_Buffers[cur].data)[pos] ];
+					continue;
+				}
+			}
+
+			// Size may not be multiples bytes
+			uint8_t bytes = Pixel_Buffers[cur].width >> 3;
+			uint16_t pos = ( chan - Pixel_Buffers[cur].offset ) * bytes;
+			memcpy(
+				(uint8_t*)LED_Buffers[cur].data + pos,
+				(uint8_t*)Pixel_Buffers[cur].data + pos,
+				bytes
+			);
+		}
+	}
+
+	// Iterate over each of the modified pixels, applying the appropriate profile to each one
 	for ( uint16_t pxin = 0; pxin < Pixel_TotalPixels_KLL; pxin++ )
 	{
 		// Select profile
@@ -2341,178 +2932,43 @@ void Pixel_SecondaryProcessing()
 			continue;
 		}
 
+		// Unmodified pixel, LED buffer is already up to date
+		const PixelElement *elem = &Pixel_Mapping[pxin];
+		if ( !Pixel_pixelDirty( elem ) )
+		{
+			continue;
+		}
+
 		// All profiles start from 1
-		PixelFadeProfile *profile = &Pixel_pixel_fade_profile_entries[profile_in - 1];
-		PixelPeriodConfig *period = &profile->conf[profile->period_conf];
+		// Make sure the lookup table matches the current profile state
+		if ( Pixel_fadeLutStale & (1 << (profile_in - 1)) )
+		{
+			Pixel_fadeLutUpdate( profile_in - 1 );
+		}
+		const uint8_t *lut = Pixel_pixel_fade_profile_entries[profile_in - 1].lut;
 
 		// Lookup channels of the pixel
-		const PixelElement *elem = &Pixel_Mapping[pxin];
 		for ( uint8_t ch = 0; ch < elem->channels; ch++ )
 		{
 			// Lookup PixelBuf containing the channel
+			// The fade is always computed from the KLL buffer value (src) so unmodified channels are not faded twice
 			uint16_t chan = elem->indices[ch];
 			PixelBuf *buf = LED_bufferMap( chan );
+			PixelBuf *src = Pixel_bufferMap( chan );
+			Pixel_bufferChanged |= 1UL << ( buf - LED_Buffers );
 
-			// Lookup memory location
-			// Then apply fade depending on the current position
-			//
-			// Percentage calculation using 32-bit integer instead of float
-			// This is just a: pos / end * current value of LED
-			// Ignores rounding
-			// For 8-bit values, the maximum percentage spread must be no greater than 25-bits
-			// e.g. 1 << 24
-			uint32_t val;
-			switch (buf->width)
+			// Apply brightness, gamma and fade using the profile lookup table
+			// Only the lower 8 bits of each channel are used
+			switch ( buf->width )
 			{
 			case 8:
-				switch ( profile->period_conf )
-				{
-				// Off -> On
-				case PixelPeriodIndex_Off_to_On:
-				// On -> Off
-				case PixelPeriodIndex_On_to_Off:
-					// If start and end are set to 0, ignore
-					if ( period->end == 0 && period->start == 0 )
-					{
-						val = (uint8_t)((uint8_t*)buf->data)[chan - buf->offset];
-						val = Pixel_ApplyFadeBrightness(profile->brightness, val);
-						if (gamma_enabled) {
-							val = gamma_table[val];
-						}
-						((uint8_t*)buf->data)[chan - buf->offset] = (uint8_t)val;
-						break;
-					}
-
-					val = (uint8_t)((uint8_t*)buf->data)[chan - buf->offset];
-					val = Pixel_ApplyFadeBrightness(profile->brightness, val);
-					if (gamma_enabled) {
-						val = gamma_table[val];
-					}
-					val *= profile->pos;
-					val >>= period->end;
-					((uint8_t*)buf->data)[chan - buf->offset] = (uint8_t)val;
-					break;
-				// On hold time
-				case PixelPeriodIndex_On:
-					val = (uint8_t)((uint8_t*)buf->data)[chan - buf->offset];
-					val = Pixel_ApplyFadeBrightness(profile->brightness, val);
-					if (gamma_enabled) {
-						val = gamma_table[val];
-					}
-					((uint8_t*)buf->data)[chan - buf->offset] = (uint8_t)val;
-					break;
-				// Off hold time
-				case PixelPeriodIndex_Off:
-				{
-					PixelPeriodConfig *prev = &profile->conf[PixelPeriodIndex_On_to_Off];
-
-					// If the previous config was disabled, do not set to 0
-					if ( prev->start == 0 && prev->end == 0 )
-					{
-						val = (uint8_t)((uint8_t*)buf->data)[chan - buf->offset];
-						val = Pixel_ApplyFadeBrightness(profile->brightness, val);
-						if (gamma_enabled) {
-							val = gamma_table[val];
-						}
-						((uint8_t*)buf->data)[chan - buf->offset] = (uint8_t)val;
-						break;
-					}
-
-					// If the previous On->Off change didn't go to fully off
-					// Calculate the value based off the previous config
-					val = 0;
-					if ( prev->start != 0 )
-					{
-						val = (uint8_t)((uint8_t*)buf->data)[chan - buf->offset];
-						val = Pixel_ApplyFadeBrightness(profile->brightness, val);
-						if (gamma_enabled) {
-							val = gamma_table[val];
-						}
-						val *= (1 << prev->start) - 1;
-						val >>= prev->end;
-					}
-
-					// Set to 0
-					((uint8_t*)buf->data)[chan - buf->offset] = (uint8_t)val;
-					break;
-				}
-				}
+				((uint8_t*)buf->data)[chan - buf->offset] = lut[ ((uint8_t*)src->data)[chan - buf->offset] ];
 				break;
 
 			case 16:
-				switch ( profile->period_conf )
-				{
-				// Off -> On
-				case PixelPeriodIndex_Off_to_On:
-				// On -> Off
-				case PixelPeriodIndex_On_to_Off:
-					// If start and end are set to 0, ignore
-					if ( period->end == 0 && period->start == 0 )
-					{
-						val = (uint8_t)((uint16_t*)buf->data)[chan - buf->offset];
-						val = Pixel_ApplyFadeBrightness(profile->brightness, val);
-						if (gamma_enabled) {
-							val = gamma_table[val];
-						}
-						((uint16_t*)buf->data)[chan - buf->offset] = (uint8_t)val;
-						break;
-					}
-
-					val = (uint8_t)((uint16_t*)buf->data)[chan - buf->offset];
-					val = Pixel_ApplyFadeBrightness(profile->brightness, val);
-					if (gamma_enabled) {
-						val = gamma_table[val];
-					}
-					val *= profile->pos;
-					val >>= period->end;
-					((uint16_t*)buf->data)[chan - buf->offset] = (uint8_t)val;
-					break;
-				// On hold time
-				case PixelPeriodIndex_On:
-					val = (uint8_t)((uint16_t*)buf->data)[chan - buf->offset];
-					val = Pixel_ApplyFadeBrightness(profile->brightness, val);
-					if (gamma_enabled) {
-						val = gamma_table[val];
-					}
-					((uint16_t*)buf->data)[chan - buf->offset] = (uint8_t)val;
-					break;
-				// Off hold time
-				case PixelPeriodIndex_Off:
-				{
-					PixelPeriodConfig *prev = &profile->conf[PixelPeriodIndex_On_to_Off];
-
-					// If the previous config was disabled, do not set to 0
-					if ( prev->start == 0 && prev->end == 0 )
-					{
-						val = (uint8_t)((uint16_t*)buf->data)[chan - buf->offset];
-						val = Pixel_ApplyFadeBrightness(profile->brightness, val);
-						if (gamma_enabled) {
-							val = gamma_table[val];
-						}
-						((uint16_t*)buf->data)[chan - buf->offset] = (uint8_t)val;
-						break;
-					}
-
-					// If the previous On->Off change didn't go to fully off
-					// Calculate the value based off the previous config
-					val = 0;
-					if ( prev->start != 0 )
-					{
-						val = (uint8_t)((uint16_t*)buf->data)[chan - buf->offset];
-						val = Pixel_ApplyFadeBrightness(profile->brightness, val);
-						if (gamma_enabled) {
-							val = gamma_table[val];
-						}
-						val *= (1 << prev->start) - 1;
-						val >>= prev->end;
-					}
-
-					// Set to 0
-					((uint16_t*)buf->data)[chan - buf->offset] = (uint8_t)val;
-					break;
-				}
-				}
+				((uint16_t*)buf->data)[chan - buf->offset] = lut[ (uint8_t)((uint16_t*)src->data)[chan - buf->offset] ];
 				break;
+
 			default:
 				erro_printNL("Unsupported buffer width");
 				break;
@@ -2520,12 +2976,20 @@ void Pixel_SecondaryProcessing()
 		}
 	}
 
+	// All modified channels have been processed
+	memset( Pixel_dirtyChannels, 0, sizeof( Pixel_dirtyChannels ) );
+	Pixel_dirty = 0;
+
+pixel_profile_update:
 	// Increment positions of each of the active profiles
+	Pixel_fadeProfileChanged = 0;
 	for ( uint8_t proin = 0; proin < 4; proin++ )
 	{
 		// Lookup profile and current period
 		PixelFadeProfile *profile = &Pixel_pixel_fade_profile_entries[proin];
 		PixelPeriodConfig *period = &profile->conf[profile->period_conf];
+		PixelPeriodIndex prev_conf = profile->period_conf;
+		uint32_t prev_pos = profile->pos;
 
 		switch ( profile->period_conf )
 		{
@@ -2566,7 +3030,30 @@ void Pixel_SecondaryProcessing()
 			}
 			break;
 		}
+
+		// Determine if the output of the profile will change on the next frame
+		// Only the fade periods depend on the position (unless disabled)
+		period = &profile->conf[profile->period_conf];
+		if ( profile->period_conf != prev_conf )
+		{
+			Pixel_fadeProfileChanged |= 1 << proin;
+		}
+		else if ( profile->pos != prev_pos && !( period->start == 0 && period->end == 0 ) )
+		{
+			switch ( profile->period_conf )
+			{
+			case PixelPeriodIndex_Off_to_On:
+			case PixelPeriodIndex_On_to_Off:
+				Pixel_fadeProfileChanged |= 1 << proin;
+				break;
+			default:
+				break;
+			}
+		}
 	}
+
+	// Fade lookup tables are regenerated on the next use
+	Pixel_fadeLutStale |= Pixel_fadeProfileChanged;
 }
 
 
@@ -2636,11 +3123,20 @@ inline void Pixel_process()
 	Latency_start_time( pixelLatencyResource );
 
 	// Only update frame when ready
+	// With double buffering, the next frame is processed while the current frame is being sent
+	uint8_t overlap = 0;
 	switch( Pixel_FrameState )
 	{
 	case FrameState_Update:
 	case FrameState_Pause:
 		break;
+	case FrameState_Sending:
+		if ( Pixel_doubleBuffered )
+		{
+			overlap = 1;
+			break;
+		}
+		goto pixel_process_final;
 	default:
 		goto pixel_process_final;
 	}
@@ -2650,16 +3146,13 @@ inline void Pixel_process()
 	{
 	case AnimationControl_Forward:    // Ok
 	case AnimationControl_ForwardOne: // Ok + 1, then stop
-		Pixel_FrameState = FrameState_Update;
 		break;
 	case AnimationControl_Stop:       // Clear animations, then proceed forward
-		Pixel_FrameState = FrameState_Update;
 		Pixel_clearAnimations();
 		Pixel_clearPixels();
 		Pixel_animationControl = AnimationControl_Forward;
 		break;
 	case AnimationControl_Reset:      // Clear animations, then restart initial
-		Pixel_FrameState = FrameState_Update;
 		Pixel_clearAnimations();
 		Pixel_clearPixels();
 		Pixel_SecondaryProcessing_setup(); // Reset fade and gamma correction
@@ -2672,14 +3165,22 @@ inline void Pixel_process()
 		goto pixel_process_done;
 	case AnimationControl_Clear: // Clears the display, animations continue
 		Pixel_animationControl = AnimationControl_Forward;
-		Pixel_FrameState = FrameState_Update;
 		Pixel_clearPixels();
 		break;
 	default: // Pause
-		Pixel_FrameState = FrameState_Pause;
+		if ( !overlap )
+		{
+			Pixel_FrameState = FrameState_Pause;
+		}
 		goto pixel_process_final;
 	}
 
+	// Animations running, the frame state is left as-is while the previous frame is being sent
+	if ( !overlap )
+	{
+		Pixel_FrameState = FrameState_Update;
+	}
+
 	// First check if we are in a test mode
 	switch ( Pixel_testMode )
 	{
@@ -3000,7 +3501,24 @@ pixel_process_done:
 	Pixel_SecondaryProcessing();
 
 	// Frame is now ready to send
-	Pixel_FrameState = FrameState_Ready;
+	Pixel_overlapped = overlap;
+	if ( overlap )
+	{
+		// Queue the frame if the previous frame is still being sent (see Pixel_frameSent)
+		// Otherwise the send finished while processing, ready to send immediately
+		FrameState sending = FrameState_Sending;
+		if ( !__atomic_compare_exchange_n(
+			&Pixel_FrameState, &sending, FrameState_Queued,
+			0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST
+		) )
+		{
+			Pixel_FrameState = FrameState_Ready;
+		}
+	}
+	else
+	{
+		Pixel_FrameState = FrameState_Ready;
+	}
 
 pixel_process_final:
 	// End latency measurement
@@ -37,6 +37,7 @@ typedef enum FrameState {
 	FrameState_Sending, // Buffers are currently being sent, do not change
 	FrameState_Update,  // Buffers need to be updated to latest frame
 	FrameState_Pause,   // Pause frame state
+	FrameState_Queued,  // Buffers are currently being sent, next frame is ready in the back buffers (double buffering)
 } FrameState;
 
 // Pixel Change Storage
@@ -189,6 +190,18 @@ typedef struct PixelModElement {
 	                              // ( PixelElement.width / 8 + sizeof(PixelChange) ) * PixelElement.channels
 } __attribute__((packed)) PixelModElement;
 
+// Pixel Operation
+// - Decoded PixelModElement channel modification, buffer location is already resolved
+// - Compiled animation frames are a flat list of PixelOps
+#define Pixel_CompiledFramesSize Pixel_CompiledFramesSize_define
+#define Pixel_CompiledOpsSize    Pixel_CompiledOpsSize_define
+typedef struct PixelOp {
+	uint16_t offset; // Channel position within the buffer
+	uint8_t  buffer; // Pixel_Buffers index
+	uint8_t  change; // PixelChange
+	uint32_t value;  // Modification value
+} PixelOp;
+
 // Pixel Mod Data Element
 // - Each element of uint8_t data[0]
 typedef struct PixelModDataElement {
@@ -246,6 +259,7 @@ typedef struct PixelFadeProfile {
 	uint32_t pos;                 // Current position with the current PixelPeriodConfig
 	PixelPeriodIndex period_conf; // Which PixelPeriodConfig is being processed
 	uint8_t brightness;
+	uint8_t lut[256];             // Channel value -> faded value (brightness, gamma and position applied)
 } PixelFadeProfile;
 
 typedef struct PixelLEDGroupEntry {
@@ -285,3 +299,15 @@ void Pixel_setup();
 
 void Pixel_setAnimationControl( AnimationControl control );
 
+
+uint32_t Pixel_bufferChanges();
+void Pixel_bufferRefresh();
+void Pixel_setOutputBrightness( uint8_t brightness );
+
+void Pixel_setBackBuffer( uint8_t buf, void *data );
+uint8_t Pixel_frameSwap();
+void Pixel_frameSent();
+uint8_t Pixel_frameOverlapped();
+
+uint8_t Pixel_fadeLookup( uint8_t profile, uint8_t val );
+uint8_t Pixel_fadeValue( uint8_t profile, uint8_t val );
@@ -57,9 +57,11 @@ const char* layout_strings[] = { LayoutList_define };
 #define HIDIO_Max_Tx_Payload 8000
 #endif
 #define HIDIO_Id_List_MaxSize 20
+#define HIDIO_Id_Direct_Size 256
 #define HIDIO_Max_ACK_Payload 70
 #else
 #define HIDIO_Id_List_MaxSize 0
+#define HIDIO_Id_Direct_Size 0
 #define HIDIO_Max_ACK_Payload 0
 #define HIDIO_Max_Payload 0
 #define HIDIO_Max_Tx_Payload 0
@@ -81,6 +83,12 @@ typedef enum HIDIO_Info_1_Property {
 	HIDIO_Info_1_Property__Host_Software = 4,
 } HIDIO_Info_1_Property;
 
+typedef enum HIDIO_Tx_State {
+	HIDIO_Tx_State__Pending, // Needs to be sent (or re-sent)
+	HIDIO_Tx_State__Sent,    // Waiting for ACK/NAK
+	HIDIO_Tx_State__Acked,   // ACK'd, released once all older messages are ACK'd
+} HIDIO_Tx_State;
+
 
 
 // ----- Structs -----
@@ -91,6 +99,19 @@ typedef struct HIDIO_Id_Entry {
 	void *reply_func;
 } HIDIO_Id_Entry;
 
+// In-flight message in the transmit window
+// Messages are released from the tx ring buffer in order, so an ACK'd message
+// stays in the window until every message ahead of it has also been ACK'd
+typedef struct HIDIO_Tx_Slot {
+	uint32_t       id;
+	Time           sent;    // Time of last send, used for retransmit timeout
+	uint16_t       pos;     // Ring buffer position of the first packet
+	uint16_t       size;    // Bytes used in ring buffer (all packets, including headers)
+	uint16_t       packets; // Number of packets in message
+	uint8_t        retries;
+	HIDIO_Tx_State state;
+} HIDIO_Tx_Slot;
+
 
 
 // ----- Function Declarations -----
@@ -104,10 +125,14 @@ CLIDict_Def( hidioCLIDict, "HID-IO Module Commands" ) = {
 // Latency Resource
 static uint8_t hidioLatencyResource;
 
-// Id List
+// Id List (sorted by id)
 HIDIO_Id_Entry HIDIO_Id_List[ HIDIO_Id_List_MaxSize ];
 uint32_t HIDIO_Id_List_Size;
 
+// Direct lookup for low Ids, HIDIO_Id_List index + 1 (0 if not registered)
+// Higher Ids use a binary search of HIDIO_Id_List
+uint8_t HIDIO_Id_Direct[ HIDIO_Id_Direct_Size ];
+
 // Packet information
 uint16_t HIDIO_Packet_Size = 0;
 
@@ -127,6 +152,13 @@ HIDIO_Buffer_Entry *HIDIO_ack_buf;
 uint8_t HIDIO_tx_buf_data[HIDIO_Max_Tx_Payload + sizeof(HIDIO_Packet)];
 HIDIO_Buffer HIDIO_tx_buf;
 
+// Packet Tx Window
+// Ring of messages sent from HIDIO_tx_buf that are waiting to be released
+HIDIO_Tx_Slot HIDIO_tx_window[ HIDIO_TxWindow_define ];
+uint8_t HIDIO_tx_window_head;
+uint8_t HIDIO_tx_window_count;
+uint16_t HIDIO_tx_window_packets; // Number of HIDIO_tx_buf packets tracked by the window
+
 // VT Print Butter
 char HIDIO_print_buf_data[50]; // TODO: Figure out >64
 uint8_t HIDIO_print_buf_count;
@@ -202,6 +234,37 @@ void HIDIO_buffer_push_byte( HIDIO_Buffer *buffer, uint8_t byte )
 	buffer->data[ buffer->tail++ ] = byte;
 }
 
+// Push bytes to ring buffer
+// Copies at most two contiguous sections (before and after the wrap-around)
+// XXX (HaaTa): Does not check if full, that needs to be validated ahead of time
+void HIDIO_buffer_push_bytes( HIDIO_Buffer *buffer, uint8_t *data, uint16_t len )
+{
+	if ( len == 0 )
+	{
+		return;
+	}
+
+	// Check if wrap-around case
+	if ( buffer->tail == buffer->len )
+	{
+		buffer->tail = 0;
+	}
+
+	// Fits before the end of the buffer
+	uint16_t cur_len = buffer->len - buffer->tail;
+	if ( len <= cur_len )
+	{
+		memcpy( &(buffer->data[ buffer->tail ]), data, len );
+		buffer->tail += len;
+		return;
+	}
+
+	// Split around the end of the buffer
+	memcpy( &(buffer->data[ buffer->tail ]), data, cur_len );
+	memcpy( buffer->data, &data[ cur_len ], len - cur_len );
+	buffer->tail = len - cur_len;
+}
+
 // Modify buffer in place
 // XXX (HaaTa): Does not check tail bounds, responsibility of caller to verify bonuds are correct
 void HIDIO_modify_buffer( HIDIO_Buffer *buffer, uint16_t start, uint8_t *data, uint16_t len )
@@ -276,7 +339,7 @@ uint16_t HIDIO_buffer_position( HIDIO_Buffer *buffer, uint16_t cur_pos, uint16_t
 {
 	if ( cur_pos + distance >= buffer->len )
 	{
-		return buffer->len - (cur_pos + distance);
+		return cur_pos + distance - buffer->len;
 	}
 	else
 	{
@@ -874,11 +937,68 @@ void HIDIO_register_id( uint32_t id, void* incoming_call_func, void* incoming_re
 		return;
 	}
 
-	// Add id to unsorted list (no reason to sort, as Ids may not be contiguous)
-	HIDIO_Id_Entry *entry = &HIDIO_Id_List[ HIDIO_Id_List_Size++ ];
+	// Find sorted position, replacing the entry if the id is already registered
+	uint32_t pos = 0;
+	while ( pos < HIDIO_Id_List_Size && HIDIO_Id_List[ pos ].id < id )
+	{
+		pos++;
+	}
+	if ( pos == HIDIO_Id_List_Size || HIDIO_Id_List[ pos ].id != id )
+	{
+		memmove(
+			&HIDIO_Id_List[ pos + 1 ],
+			&HIDIO_Id_List[ pos ],
+			( HIDIO_Id_List_Size - pos ) * sizeof(HIDIO_Id_Entry)
+		);
+		HIDIO_Id_List_Size++;
+	}
+
+	HIDIO_Id_Entry *entry = &HIDIO_Id_List[ pos ];
 	entry->id = id;
 	entry->call_func = incoming_call_func;
 	entry->reply_func = incoming_reply_func;
+
+	// Rebuild direct lookup, list indices may have shifted
+	memset( HIDIO_Id_Direct, 0, sizeof(HIDIO_Id_Direct) );
+	for ( pos = 0; pos < HIDIO_Id_List_Size && HIDIO_Id_List[ pos ].id < HIDIO_Id_Direct_Size; pos++ )
+	{
+		HIDIO_Id_Direct[ HIDIO_Id_List[ pos ].id ] = pos + 1;
+	}
+}
+
+// Lookup registered id
+// Returns 0 if the id is not registered
+static HIDIO_Id_Entry *HIDIO_lookup_id( uint32_t id )
+{
+	// Low Ids
+	if ( id < HIDIO_Id_Direct_Size )
+	{
+		uint8_t index = HIDIO_Id_Direct[ id ];
+		return index ? &HIDIO_Id_List[ index - 1 ] : 0;
+	}
+
+	// Binary search
+	uint32_t low = 0;
+	uint32_t high = HIDIO_Id_List_Size;
+	while ( low < high )
+	{
+		uint32_t mid = (low + high) / 2;
+		if ( HIDIO_Id_List[ mid ].id < id )
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	if ( low < HIDIO_Id_List_Size && HIDIO_Id_List[ low ].id == id )
+	{
+		return &HIDIO_Id_List[ low ];
+	}
+
+	return 0;
 }
 
 // Initiate registered call function
@@ -896,18 +1016,15 @@ HIDIO_Return HIDIO_call_id( uint32_t id, uint16_t buf_pos, uint8_t irq )
 	HIDIO_Return retval = HIDIO_Return__Unknown;
 
 	// Find id
-	for ( uint16_t pos = 0; pos < HIDIO_Id_List_Size; pos++ )
+	HIDIO_Id_Entry *id_entry = HIDIO_lookup_id( id );
+	if ( id_entry )
 	{
-		// Match id
-		if ( HIDIO_Id_List[ pos ].id == id )
-		{
-			// Map function pointer
-			HIDIO_Return (*func)(uint16_t, uint8_t) = \
-				(HIDIO_Return(*)(uint16_t, uint8_t))(HIDIO_Id_List[ pos ].call_func);
+		// Map function pointer
+		HIDIO_Return (*func)(uint16_t, uint8_t) = \
+			(HIDIO_Return(*)(uint16_t, uint8_t))(id_entry->call_func);
 
-			// Call function
-			retval = func( buf_pos, irq );
-		}
+		// Call function
+		retval = func( buf_pos, irq );
 	}
 
 	// Enough space to store header
@@ -955,6 +1072,161 @@ HIDIO_Return HIDIO_call_id( uint32_t id, uint16_t buf_pos, uint8_t irq )
 	return retval;
 }
 
+// Find the oldest unacknowledged message in the transmit window with the given id
+// Returns 0 if there is no matching message
+HIDIO_Tx_Slot *HIDIO_tx_window_find( uint32_t id )
+{
+	for ( uint8_t c = 0; c < HIDIO_tx_window_count; c++ )
+	{
+		HIDIO_Tx_Slot *slot = &HIDIO_tx_window[ (HIDIO_tx_window_head + c) % HIDIO_TxWindow_define ];
+		if ( slot->id == id && slot->state != HIDIO_Tx_State__Acked )
+		{
+			return slot;
+		}
+	}
+
+	return 0;
+}
+
+// Schedule message for retransmission
+// Once out of retries, the message is marked as done and dropped on the next release
+void HIDIO_tx_window_retry( HIDIO_Tx_Slot *slot )
+{
+	if ( slot->retries >= HIDIO_TxRetries_define )
+	{
+		uint16_t connected = HIDIO_VT_Connected;
+		HIDIO_VT_Connected = 0;
+			warn_print("Dropping HIDIO message, no ACK: ");
+			printInt32( slot->id );
+			print(NL);
+		HIDIO_VT_Connected = connected;
+		slot->state = HIDIO_Tx_State__Acked;
+		return;
+	}
+
+	slot->retries++;
+	slot->state = HIDIO_Tx_State__Pending;
+}
+
+// Release ACK'd messages from the front of the transmit window (and tx buffer)
+void HIDIO_tx_window_release()
+{
+	while ( HIDIO_tx_window_count > 0 )
+	{
+		HIDIO_Tx_Slot *slot = &HIDIO_tx_window[ HIDIO_tx_window_head ];
+		if ( slot->state != HIDIO_Tx_State__Acked )
+		{
+			break;
+		}
+
+		// Pop bytes and decrement packet ready counter
+		if ( HIDIO_buffer_pop_bytes( &HIDIO_tx_buf, slot->size ) )
+		{
+			HIDIO_tx_buf.packets_ready -= slot->packets;
+		}
+		// Failed pop, generally popping more buffer than is available
+		// (this is very bad, but recovering anyways)
+		else
+		{
+			HIDIO_tx_buf.packets_ready = 0;
+			HIDIO_tx_buf.head = 0;
+			HIDIO_tx_buf.tail = 0;
+			HIDIO_tx_window_count = 0;
+			HIDIO_tx_window_packets = 0;
+			break;
+		}
+
+		HIDIO_tx_window_head = (HIDIO_tx_window_head + 1) % HIDIO_TxWindow_define;
+		HIDIO_tx_window_count--;
+		HIDIO_tx_window_packets -= slot->packets;
+	}
+}
+
+// Add completed messages from the tx buffer to the transmit window, until the window is full
+void HIDIO_tx_window_fill()
+{
+	while ( HIDIO_tx_window_count < HIDIO_TxWindow_define )
+	{
+		// Start of the first message not yet in the window
+		uint16_t start = HIDIO_tx_buf.head;
+		if ( HIDIO_tx_window_count > 0 )
+		{
+			HIDIO_Tx_Slot *last = &HIDIO_tx_window[
+				(HIDIO_tx_window_head + HIDIO_tx_window_count - 1) % HIDIO_TxWindow_define
+			];
+			start = HIDIO_buffer_position( &HIDIO_tx_buf, last->pos, last->size );
+		}
+
+		// Walk packet headers until the end of the message
+		uint16_t unassigned = HIDIO_tx_buf.packets_ready - HIDIO_tx_window_packets;
+		uint16_t pos = start;
+		uint16_t size = 0;
+		uint16_t packets = 0;
+		uint8_t continued = 1;
+		uint32_t id = 0;
+		while ( continued && packets < unassigned )
+		{
+			// Enough space to store header
+			uint8_t tmpdata[sizeof(HIDIO_Packet32)];
+			HIDIO_Packet *packet = (HIDIO_Packet*)HIDIO_buffer_munch( &HIDIO_tx_buf, tmpdata, pos, sizeof(tmpdata) ).buf;
+			if ( packets == 0 )
+			{
+				id = HIDIO_buffer_id( packet );
+			}
+
+			// Determine size of packet
+			uint16_t datasize = ((packet->upper_len << 8) | packet->len) + 2;
+			continued = packet->cont;
+
+			pos = HIDIO_buffer_position( &HIDIO_tx_buf, pos, datasize );
+			size += datasize;
+			packets++;
+		}
+
+		// Stop if message is still being generated (or there are no more messages)
+		if ( continued )
+		{
+			break;
+		}
+
+		HIDIO_Tx_Slot *slot = &HIDIO_tx_window[ (HIDIO_tx_window_head + HIDIO_tx_window_count) % HIDIO_TxWindow_define ];
+		slot->id = id;
+		slot->pos = start;
+		slot->size = size;
+		slot->packets = packets;
+		slot->retries = 0;
+		slot->state = HIDIO_Tx_State__Pending;
+
+		HIDIO_tx_window_count++;
+		HIDIO_tx_window_packets += packets;
+	}
+}
+
+// Send every packet of a message in the transmit window
+void HIDIO_tx_window_send( HIDIO_Tx_Slot *slot )
+{
+	uint16_t pos = slot->pos;
+	for ( uint16_t c = 0; c < slot->packets; c++ )
+	{
+		// Prepare 64 byte packet
+		// TODO (HaaTa): Handle internal max size
+		uint8_t tmpdata[64];
+		HIDIO_Packet *packet = (HIDIO_Packet*)HIDIO_buffer_munch( &HIDIO_tx_buf, tmpdata, pos, HIDIO_Packet_Size ).buf;
+
+		// Send packet
+		// TODO (HaaTa): Check error?
+		Output_rawio_sendbuffer( (char*)packet );
+
+		// Next packet
+		uint16_t datasize = (packet->upper_len << 8) | packet->len;
+		pos = HIDIO_buffer_position( &HIDIO_tx_buf, pos, datasize + 2 );
+	}
+
+	// Wait for ACK/NAK, the message is released (or re-sent) once received
+	slot->sent = Time_now();
+	slot->state = HIDIO_Tx_State__Sent;
+}
+
 // Initiate registered reply function
 // id - Function id
 // buf - Pointer to the ack buffer
@@ -964,72 +1236,43 @@ HIDIO_Return HIDIO_reply_id( uint32_t id, uint8_t *buf, uint8_t irq )
 	HIDIO_Return retval = HIDIO_Return__Unknown;
 
 	// Find id
-	for ( uint16_t pos = 0; pos < HIDIO_Id_List_Size; pos++ )
+	HIDIO_Id_Entry *id_entry = HIDIO_lookup_id( id );
+	if ( id_entry )
 	{
-		// Match id
-		if ( HIDIO_Id_List[ pos ].id == id )
-		{
-			// Map function pointer
-			HIDIO_Return (*func)(HIDIO_Buffer_Entry*, uint8_t) = \
-				(HIDIO_Return(*)(HIDIO_Buffer_Entry*, uint8_t))(HIDIO_Id_List[ pos ].reply_func);
+		// Map function pointer
+		HIDIO_Return (*func)(HIDIO_Buffer_Entry*, uint8_t) = \
+			(HIDIO_Return(*)(HIDIO_Buffer_Entry*, uint8_t))(id_entry->reply_func);
 
-			// Call function
-			retval = func( (HIDIO_Buffer_Entry*)buf, irq );
-			break;
-		}
+		// Call function
+		retval = func( (HIDIO_Buffer_Entry*)buf, irq );
 	}
 
-	// Enough space to store header
-	uint8_t tmpdata[6];
-	uint16_t datasize;
-	uint8_t continued;
-	HIDIO_Packet *packet;
+	// Oldest message waiting on this id
+	HIDIO_Tx_Slot *slot = HIDIO_tx_window_find( id );
+	if ( slot == 0 )
+	{
+		return retval;
+	}
 
 	switch ( retval )
 	{
-	// HIDIO_Return__Ok, we can pop the most recent tx_buf packet
+	// HIDIO_Return__Ok, release the message (NAKs are re-sent)
 	case HIDIO_Return__Ok:
-		// Cleanup until a non-continued packet
-		while ( HIDIO_tx_buf.packets_ready > 0 )
+		if ( ((HIDIO_Buffer_Entry*)buf)->type == HIDIO_Packet_Type__NAK )
 		{
-			packet = (HIDIO_Packet*)HIDIO_buffer_munch( &HIDIO_tx_buf, tmpdata, HIDIO_tx_buf.head, sizeof(tmpdata) ).buf;
-
-			// Determine size of data
-			datasize = (packet->upper_len << 8) | packet->len;
-
-			// Check if continued
-			continued = packet->cont;
-
-			// Pop bytes and decrement packet ready counter
-			if ( HIDIO_buffer_pop_bytes( &HIDIO_tx_buf, datasize + 2 ) )
-			{
-				HIDIO_tx_buf.packets_ready--;
-			}
-			// Failed pop, generally popping more buffer than is available
-			// (this is very bad, but recovering anyways)
-			else
-			{
-				HIDIO_tx_buf.packets_ready = 0;
-				HIDIO_tx_buf.head = 0;
-				HIDIO_tx_buf.tail = 0;
-				break;
-			}
-
-			// If there aren't any more packets (continued packets only), stop
-			if ( !continued )
-			{
-				break;
-			}
+			HIDIO_tx_window_retry( slot );
+			break;
 		}
 
-		// Unset waiting for ACK packet
-		HIDIO_tx_buf.waiting = 0;
+		// Messages are released in order, anything after a missing ACK is held until it arrives
+		slot->state = HIDIO_Tx_State__Acked;
+		HIDIO_tx_window_release();
 		break;
 
-	// HIDIO_Return__InBuffer_Fail, Nak (or related), drop all continued packets if necessary
+	// HIDIO_Return__InBuffer_Fail, Nak (or related), re-send message
 	case HIDIO_Return__InBuffer_Fail:
-		// TODO (HaaTa)
-		print("FAIL"NL);
+		HIDIO_tx_window_retry( slot );
+		HIDIO_tx_window_release();
 		break;
 
 	default:
@@ -1071,6 +1314,10 @@ void HIDIO_flush()
 	HIDIO_tx_buf.cur_buf_head = 0;
 	HIDIO_tx_buf.packets_ready = 0;
 	HIDIO_tx_buf.waiting = 0;
+
+	HIDIO_tx_window_head = 0;
+	HIDIO_tx_window_count = 0;
+	HIDIO_tx_window_packets = 0;
 }
 
 // HID-IO Module Setup
@@ -1112,6 +1359,7 @@ inline void HIDIO_setup()
 
 	// Reset internal id list
 	HIDIO_Id_List_Size = 0;
+	memset( HIDIO_Id_Direct, 0, sizeof(HIDIO_Id_Direct) );
 
 	// Register internal Ids (for incoming packets)
 	HIDIO_register_id( 0x00, (void*)HIDIO_supported_0_call, (void*)HIDIO_supported_0_reply );
@@ -1248,13 +1496,9 @@ void HIDIO_process_incoming_packet( uint8_t *buf, uint8_t irq )
 			// Determine buffer position where we are starting
 			HIDIO_assembly_buf.cur_buf_head = HIDIO_assembly_buf.tail;
 
-			// Copy byte-by-byte into ring buffer
-			// TODO (HaaTa): Make more efficient by checking conditions and using memcpy when appropriate
+			// Copy into ring buffer
 			// First the entry info
-			for ( uint8_t c = 0; c < sizeof(HIDIO_Buffer_Entry); c++ )
-			{
-				HIDIO_buffer_push_byte( &HIDIO_assembly_buf, ((uint8_t*)&entry)[c] );
-			}
+			HIDIO_buffer_push_bytes( &HIDIO_assembly_buf, (uint8_t*)&entry, sizeof(HIDIO_Buffer_Entry) );
 		}
 		else
 		{
@@ -1288,10 +1532,7 @@ void HIDIO_process_incoming_packet( uint8_t *buf, uint8_t irq )
 		HIDIO_assembly_buf.waiting = packet->cont;
 
 		// Then the payload data
-		for ( uint16_t c = 0; c < payload_len; c++ )
-		{
-			HIDIO_buffer_push_byte( &HIDIO_assembly_buf, data[c] );
-		}
+		HIDIO_buffer_push_bytes( &HIDIO_assembly_buf, data, payload_len );
 
 		// If finished, send to appropriate registered callback
 		HIDIO_assembly_buf.packets_ready++;
@@ -1410,19 +1651,16 @@ inline void HIDIO_process()
 	// Start latency measurement
 	Latency_start_time( hidioLatencyResource );
 
-	// TODO (HaaTa): Handle timeouts and lost packets
-
 	// Retrieve incoming packets
 	// XXX (HaaTa): This only applies to RawIO implementations that enqueue incoming packets (e.g. Kinetis)
 	//              SAM4S has an interrupt per incoming packet, so each packet is processed as it comes in.
-	while ( Output_rawio_availablechar() )
+	// Packets are processed in place, in the RawIO receive buffer
+	uint8_t *rx_buf;
+	while ( ( rx_buf = (uint8_t*)Output_rawio_peekbuffer() ) )
 	{
-		// XXX Double copy is done here with getbuffer
-		uint8_t tmpdata[ HIDIO_MAX_PACKET_SIZE ];
-		Output_rawio_getbuffer( (char*)&tmpdata );
-
 		// Process Packet, regular process (no interrupt)
-		HIDIO_process_incoming_packet( tmpdata, 0 );
+		HIDIO_process_incoming_packet( rx_buf, 0 );
+		Output_rawio_releasebuffer();
 	}
 
 	// Send all ACK packets
@@ -1459,29 +1697,27 @@ inline void HIDIO_process()
 		}
 	}
 
-	// Send outgoing packet, we can only send one at a time
-	// and the next one can only be sent after an ACK is recieved
-	uint16_t next_packet_pos = HIDIO_tx_buf.head;
-	uint16_t packets_ready = HIDIO_tx_buf.packets_ready;
-	while ( packets_ready > 0 && HIDIO_tx_buf.waiting == 0 )
+	// Re-send messages that have not been ACK'd/NAK'd in time
+	for ( uint8_t c = 0; c < HIDIO_tx_window_count; c++ )
 	{
-		// Prepare 64 byte packet
-		// TODO (HaaTa): Handle internal max size
-		uint8_t tmpdata[64];
-		HIDIO_Munch munch = HIDIO_buffer_munch( &HIDIO_tx_buf, tmpdata, next_packet_pos, HIDIO_Packet_Size );
-		HIDIO_Packet *packet = (HIDIO_Packet*)munch.buf;
-		next_packet_pos = munch.next_pos;
-
-		// Send packet
-		// TODO (HaaTa): Check error?
-		Output_rawio_sendbuffer( (char*)packet );
-
-		// Indicate waiting for ACK packet
-		// Once ACK has been received (or NAK) the packet will be released
-		HIDIO_tx_buf.waiting = packet->cont ? 0 : 1;
+		HIDIO_Tx_Slot *slot = &HIDIO_tx_window[ (HIDIO_tx_window_head + c) % HIDIO_TxWindow_define ];
+		if ( slot->state == HIDIO_Tx_State__Sent && Time_duration_ms( slot->sent ) > HIDIO_TxTimeout_define )
+		{
+			HIDIO_tx_window_retry( slot );
+		}
+	}
+	HIDIO_tx_window_release();
 
-		// Next packet
-		packets_ready--;
+	// Send outgoing messages, up to HIDIO_TxWindow messages may be waiting for an ACK at once
+	// Re-sends go first as they are older
+	HIDIO_tx_window_fill();
+	for ( uint8_t c = 0; c < HIDIO_tx_window_count; c++ )
+	{
+		HIDIO_Tx_Slot *slot = &HIDIO_tx_window[ (HIDIO_tx_window_head + c) % HIDIO_TxWindow_define ];
+		if ( slot->state == HIDIO_Tx_State__Pending )
+		{
+			HIDIO_tx_window_send( slot );
+		}
 	}
 
 	// End latency measurement
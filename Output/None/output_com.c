@@ -119,6 +119,19 @@ int Output_rawio_getbuffer( char* buffer )
 }
 
 
+// UART RawIO peek buffer
+char* Output_rawio_peekbuffer()
+{
+	return 0;
+}
+
+
+// UART RawIO release buffer
+void Output_rawio_releasebuffer()
+{
+}
+
+
 // UART RawIO send buffer
 int Output_rawio_sendbuffer( char* buffer )
 {
@@ -129,6 +129,21 @@ int Output_rawio_getbuffer( char* buffer )
 }
 
 
+// RTT RawIO peek buffer
+// XXX (HaaTa) Not implemented
+char* Output_rawio_peekbuffer()
+{
+	return 0;
+}
+
+
+// RTT RawIO release buffer
+// XXX (HaaTa) Not implemented
+void Output_rawio_releasebuffer()
+{
+}
+
+
 // RTT RawIO send buffer
 // XXX (HaaTa) Not implemented
 int Output_rawio_sendbuffer( char* buffer )
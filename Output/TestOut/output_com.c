@@ -127,6 +127,20 @@ int Output_rawio_getbuffer( char* buffer )
 }
 
 
+// TestOut RawIO peek buffer
+char* Output_rawio_peekbuffer()
+{
+	return TestOut_rawio_peekbuffer();
+}
+
+
+// TestOut RawIO release buffer
+void Output_rawio_releasebuffer()
+{
+	TestOut_rawio_releasebuffer();
+}
+
+
 // TestOut RawIO send buffer
 int Output_rawio_sendbuffer( char* buffer )
 {
@@ -30,6 +30,7 @@
 #include <output_com.h>
 #include <output_usb.h>
 #include <print.h>
+#include <trace.h>
 
 // KLL
 #include <kll.h>
@@ -134,6 +135,9 @@ inline void TestOut_periodic()
 		Output_callback( "keyboard_send", "" );
 	}
 
+	// Record latency of traced key events
+	Trace_reportSent();
+
 	// Signal Scan Module we are finished
 	switch ( USBKeys_Protocol )
 	{
@@ -215,6 +219,33 @@ int TestOut_rawio_getbuffer( char* buffer )
 }
 
 
+// USB RawIO peek buffer
+// The host callback copies the packet, so it is held in a local buffer until released
+// XXX Must be a 64 byte buffer
+static char TestOut_rawio_peek_data[64];
+static int TestOut_rawio_peeked = 0;
+char* TestOut_rawio_peekbuffer()
+{
+#if enableRawIO_define == 1
+	if ( !TestOut_rawio_peeked )
+	{
+		TestOut_rawio_peeked = Output_callback( "rawio_rx", TestOut_rawio_peek_data );
+	}
+
+	return TestOut_rawio_peeked ? TestOut_rawio_peek_data : 0;
+#else
+	return 0;
+#endif
+}
+
+
+// USB RawIO release buffer
+void TestOut_rawio_releasebuffer()
+{
+	TestOut_rawio_peeked = 0;
+}
+
+
 // USB RawIO send buffer
 // XXX Must be a 64 byte buffer
 int TestOut_rawio_sendbuffer( char* buffer )
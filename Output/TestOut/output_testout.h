@@ -63,6 +63,8 @@ int TestOut_putstr( char* str );
 // RawIO Interface
 unsigned int TestOut_rawio_availablechar();
 int TestOut_rawio_getbuffer( char* buffer );
+char* TestOut_rawio_peekbuffer();
+void TestOut_rawio_releasebuffer();
 int TestOut_rawio_sendbuffer( char* buffer );
 
 
@@ -128,6 +128,21 @@ int Output_rawio_getbuffer( char* buffer )
 }
 
 
+// UART RawIO peek buffer
+// XXX (HaaTa) Not implemented
+char* Output_rawio_peekbuffer()
+{
+	return 0;
+}
+
+
+// UART RawIO release buffer
+// XXX (HaaTa) Not implemented
+void Output_rawio_releasebuffer()
+{
+}
+
+
 // UART RawIO send buffer
 // XXX (HaaTa) Not implemented
 int Output_rawio_sendbuffer( char* buffer )
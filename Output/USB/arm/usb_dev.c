@@ -31,10 +31,14 @@
 
 // ----- Includes -----
 
+// Compiler Includes
+#include <string.h>
+
 // Project Includes
 #include <Lib/OutputLib.h>
 #include <print.h>
 #include <kll_defs.h>
+#include <Lib/periodic.h>
 
 // Local Includes
 #include "output_usb.h"
@@ -391,7 +395,7 @@ void usb_setup()
 			if ( epconf & USB_ENDPT_EPRXEN )
 			{
 				usb_packet_t *p;
-				p = usb_malloc();
+				p = usb_malloc_endpoint( i );
 				if ( p )
 				{
 					table[ index( i, RX, EVEN ) ].addr = p->buf;
@@ -402,7 +406,7 @@ void usb_setup()
 					table[ index( i, RX, EVEN ) ].desc = 0;
 					usb_rx_memory_needed++;
 				}
-				p = usb_malloc();
+				p = usb_malloc_endpoint( i );
 				if ( p )
 				{
 					table[ index( i, RX, ODD ) ].addr = p->buf;
@@ -1293,13 +1297,15 @@ uint32_t usb_tx_packet_count( uint32_t endpoint )
 // likely calling usb_malloc to obtain memory for transmitting.  When the
 // user is creating data very quickly, their consumption could starve reception
 // without this prioritization.  The packet buffer (input) is assigned to the
-// first endpoint needing memory.
+// first endpoint needing memory that is still within its buffer quota.
+// Returns 1 if the packet was taken, 0 if the caller should free it.
 //
-void usb_rx_memory( usb_packet_t *packet )
+uint8_t usb_rx_memory( usb_packet_t *packet )
 {
 	//print("USB RX MEMORY");
 	unsigned int i;
 	const uint8_t *cfg;
+	uint8_t starving = 0;
 
 	cfg = usb_endpoint_config_table;
 	//serial_print("rx_mem:");
@@ -1310,33 +1316,42 @@ void usb_rx_memory( usb_packet_t *packet )
 		{
 			if ( table[ index( i, RX, EVEN ) ].desc == 0 )
 			{
+				starving = 1;
+				if ( !usb_mem_assign( packet, i ) )
+					continue;
 				table[ index( i, RX, EVEN ) ].addr = packet->buf;
 				table[ index( i, RX, EVEN ) ].desc = BDT_DESC( 64, 0 );
 				usb_rx_memory_needed--;
 				__enable_irq();
 				//serial_phex(i);
 				//serial_print(",even\n");
-				return;
+				return 1;
 			}
 			if ( table[ index( i, RX, ODD ) ].desc == 0 )
 			{
+				starving = 1;
+				if ( !usb_mem_assign( packet, i ) )
+					continue;
 				table[ index( i, RX, ODD ) ].addr = packet->buf;
 				table[ index( i, RX, ODD ) ].desc = BDT_DESC( 64, 1 );
 				usb_rx_memory_needed--;
 				__enable_irq();
 				//serial_phex(i);
 				//serial_print(",odd\n");
-				return;
+				return 1;
 			}
 		}
 	}
+	// we should never reach this point without a starving endpoint.  If we
+	// get here, it means usb_rx_memory_needed was set greater than zero, but
+	// no memory was actually needed.
+	// Starving endpoints over quota wait until their own packets are freed.
+	if ( !starving )
+	{
+		usb_rx_memory_needed = 0;
+	}
 	__enable_irq();
-	// we should never reach this point.  If we get here, it means
-	// usb_rx_memory_needed was set greater than zero, but no memory
-	// was actually needed.
-	usb_rx_memory_needed = 0;
-	usb_free( packet );
-	return;
+	return 0;
 }
 #endif
 
@@ -1466,6 +1481,35 @@ void usb_tx( uint32_t endpoint, usb_packet_t *packet )
 #endif
 }
 
+// Overwrite the newest packet still waiting in the endpoint transmit queue
+// Packets already handed to the hardware (BDT) are never modified
+// Returns 1 if a queued packet was updated, 0 if nothing is waiting
+uint8_t usb_tx_update( uint32_t endpoint, const uint8_t *buf, uint16_t len )
+{
+#if defined(_kinetis_)
+	usb_packet_t *packet;
+
+	endpoint--;
+	if ( endpoint >= NUM_ENDPOINTS )
+		return 0;
+	__disable_irq();
+	// tx_last is only valid while tx_first is set
+	if ( tx_first[ endpoint ] == NULL )
+	{
+		__enable_irq();
+		return 0;
+	}
+	packet = tx_last[ endpoint ];
+	memcpy( packet->buf, buf, len );
+	packet->len = len;
+	__enable_irq();
+	return 1;
+
+#else
+	return 0;
+#endif
+}
+
 
 void usb_device_reload()
 {
@@ -1532,6 +1576,14 @@ restart:
 			usb_dev_sleep = 0;
 		}
 
+		// Measure the age of the report waiting for this frame
+		USB_reportSOF();
+
+#if USBSOFSync_define == 1
+		// Align periodic processing to the USB frame
+		Periodic_sync();
+#endif
+
 		USB0_ISTAT = USB_INTEN_SOFTOKEN;
 	}
 
@@ -1639,10 +1691,10 @@ restart:
 					}
 					rx_last[ endpoint ] = packet;
 					usb_rx_byte_count_data[ endpoint ] += packet->len;
-					// TODO: implement a per-endpoint maximum # of allocated packets
+					// Allocation is limited by the per-endpoint quota
 					// so a flood of incoming data on 1 endpoint doesn't starve
 					// the others if the user isn't reading it regularly
-					packet = usb_malloc();
+					packet = usb_malloc_endpoint( endpoint + 1 );
 					if ( packet )
 					{
 						b->addr = packet->buf;
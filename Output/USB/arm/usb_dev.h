@@ -62,6 +62,7 @@ void usb_reinit(); // Force restart USB interface, simulates disconnect
 void usb_isr();
 void usb_tx( uint32_t endpoint, usb_packet_t *packet );
 void usb_tx_isr( uint32_t endpoint, usb_packet_t *packet );
+uint8_t usb_tx_update( uint32_t endpoint, const uint8_t *buf, uint16_t len );
 
 uint8_t usb_resume();
 uint8_t usb_suspended();
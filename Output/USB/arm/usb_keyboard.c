@@ -55,12 +55,33 @@
 // When the PC isn't listening, how long do we wait before discarding data?
 #define TX_TIMEOUT_MS 50
 
+// Largest keyboard report (NKRO)
+#define TX_REPORT_MAX 28
+
 
 
 // ----- Variables -----
 
 static uint8_t transmit_previous_timeout = 0;
 
+// Endpoint used by each keyboard report queue
+static const uint8_t usb_keyboard_endpoint[ USBKeyboardReport_Count ] = {
+	KEYBOARD_ENDPOINT,
+	NKRO_KEYBOARD_ENDPOINT,
+	SYS_CTRL_ENDPOINT,
+};
+
+// Report waiting for a free packet, and since when
+static uint8_t usb_keyboard_deferred[ USBKeyboardReport_Count ];
+static Time usb_keyboard_deferred_start[ USBKeyboardReport_Count ];
+
+// Most recently queued report contents, and the report queued before it
+// Used to tell whether the newest report can overwrite a report still waiting in the endpoint queue
+static uint8_t usb_keyboard_last[ USBKeyboardReport_Count ][ TX_REPORT_MAX ];
+static uint8_t usb_keyboard_prev[ USBKeyboardReport_Count ][ TX_REPORT_MAX ];
+
+USBKeyboardReportStats usb_keyboard_stats[ USBKeyboardReport_Count ];
+
 
 
 // ----- Functions -----
@@ -80,7 +101,8 @@ void usb_keyboard_idle_update()
 			// Send packets for each of the keyboard interfaces
 			while ( USBKeys_idle.changed )
 			{
-				usb_keyboard_send( (USBKeys*)&USBKeys_idle, USBKeys_Protocol );
+				if ( !usb_keyboard_send( (USBKeys*)&USBKeys_idle, USBKeys_Protocol ) )
+					break;
 			}
 		}
 	}
@@ -105,63 +127,156 @@ void usb_keyboard_clear( uint8_t protocol )
 }
 
 
-// Send the contents of keyboard_keys and keyboard_modifier_keys
-void usb_keyboard_send( USBKeys *buffer, uint8_t protocol )
+// Check if a report can overwrite the last queued report
+// Only if it keeps every byte the last report changed, otherwise the host would miss a key transition
+// (e.g. a quick tap replacing a queued press with the release)
+static uint8_t usb_keyboard_mergeable( USBKeyboardReport report, const uint8_t *buf, uint16_t len )
 {
-	Time start = Time_now();
-	usb_packet_t *tx_packet;
-
-	// Wait till ready
-	while ( 1 )
+	for ( uint16_t c = 0; c < len; c++ )
 	{
-		if ( !usb_configuration )
+		if ( usb_keyboard_last[ report ][ c ] != usb_keyboard_prev[ report ][ c ]
+			&& buf[ c ] != usb_keyboard_last[ report ][ c ] )
 		{
-			erro_printNL("USB not configured...");
-			return;
+			return 0;
 		}
+	}
+	return 1;
+}
 
-		// Try to wake up the host if it's asleep
-		if ( usb_resume() )
-		{
-			// Drop packet
-			buffer->changed = USBKeyChangeState_None;
-			return;
-		}
+// Queue a report without blocking
+// If an earlier report is still waiting in the endpoint queue, the newest state overwrites it (when mergeable)
+// Returns 1 if the report was queued or coalesced, 0 if no packet is available yet
+static uint8_t usb_keyboard_queue( USBKeyboardReport report, const uint8_t *buf, uint16_t len )
+{
+	uint32_t endpoint = usb_keyboard_endpoint[ report ];
 
-		if ( protocol == 0 ) // Boot Mode
-		{
-			if ( usb_tx_packet_count( KEYBOARD_ENDPOINT ) < TX_PACKET_LIMIT )
-			{
-				tx_packet = usb_malloc();
-				if ( tx_packet )
-					break;
-			}
-		}
-		else if ( protocol == 1 ) // NKRO Mode
-		{
-			if ( usb_tx_packet_count( NKRO_KEYBOARD_ENDPOINT ) < TX_PACKET_LIMIT )
-			{
-				tx_packet = usb_malloc();
-				if ( tx_packet )
-					break;
-			}
-		}
-		else if ( buffer->changed &
-			( USBKeyChangeState_System | USBKeyChangeState_Consumer )
-		)
+	// Coalesce with the pending report
+	if ( usb_keyboard_mergeable( report, buf, len ) && usb_tx_update( endpoint, buf, len ) )
+	{
+		memcpy( usb_keyboard_last[ report ], buf, len );
+		usb_keyboard_stats[ report ].coalesced++;
+		return 1;
+	}
+
+	// Otherwise queue a new packet, if the endpoint has room
+	if ( usb_tx_packet_count( endpoint ) >= TX_PACKET_LIMIT )
+	{
+		return 0;
+	}
+
+	usb_packet_t *tx_packet = usb_malloc_endpoint( endpoint );
+	if ( !tx_packet )
+	{
+		return 0;
+	}
+
+	memcpy( tx_packet->buf, buf, len );
+	tx_packet->len = len;
+
+	// Send USB Packet
+	usb_tx( endpoint, tx_packet );
+	USB_reportQueued();
+	usb_keyboard_stats[ report ].queued++;
+
+	memcpy( usb_keyboard_prev[ report ], usb_keyboard_last[ report ], len );
+	memcpy( usb_keyboard_last[ report ], buf, len );
+	return 1;
+}
+
+
+// Send the contents of keyboard_keys and keyboard_modifier_keys
+// Never waits for the USB stack, a report that cannot be queued yet is left marked as changed
+// Returns 1 if buffer->changed was updated (report queued, coalesced or dropped), 0 if deferred
+uint8_t usb_keyboard_send( USBKeys *buffer, uint8_t protocol )
+{
+	USBKeyboardReport report;
+	uint8_t tx_buf[ TX_REPORT_MAX ];
+	uint16_t len;
+
+	if ( !usb_configuration )
+	{
+		erro_printNL("USB not configured...");
+		return 0;
+	}
+
+	// Determine which report needs to be sent
+	// System control and consumer control keys take priority
+	if ( buffer->changed & ( USBKeyChangeState_System | USBKeyChangeState_Consumer ) )
+	{
+		report = USBKeyboardReport_SysCtrl;
+	}
+	else if ( protocol == 0 ) // Boot Mode
+	{
+		report = USBKeyboardReport_Boot;
+	}
+	else if ( protocol == 1 ) // NKRO Mode
+	{
+		report = USBKeyboardReport_NKRO;
+	}
+	else
+	{
+		// Nothing to send
+		buffer->changed = USBKeyChangeState_None;
+		return 1;
+	}
+
+	// Try to wake up the host if it's asleep
+	if ( usb_resume() )
+	{
+		// Drop packet
+		usb_keyboard_stats[ report ].dropped++;
+		usb_keyboard_deferred[ report ] = 0;
+		buffer->changed = USBKeyChangeState_None;
+		return 1;
+	}
+
+	// Build report
+	switch ( report )
+	{
+	case USBKeyboardReport_SysCtrl:
+		tx_buf[0] = (uint8_t)(buffer->cons_ctrl & 0x00FF);
+		tx_buf[1] = (uint8_t)(buffer->cons_ctrl >> 8);
+		tx_buf[2] = buffer->sys_ctrl - 0x80;
+		len = 3;
+		break;
+
+	case USBKeyboardReport_Boot:
+		tx_buf[0] = buffer->modifiers;
+		tx_buf[1] = 0;
+		memcpy( &tx_buf[2], buffer->keys, USB_BOOT_MAX_KEYS );
+		len = 8;
+		break;
+
+	default:
+		// Modifiers
+		tx_buf[0] = buffer->modifiers;
+
+		// 4-164 (first 21 bytes)
+		// 0-3 and 165-168 are masked by the descriptor (padding)
+		memcpy( &tx_buf[1], buffer->keys, 21 );
+
+		// 176-221 (last 6 bytes)
+		// 222-223 are masked by the descriptor (padding)
+		memcpy( &tx_buf[22], buffer->keys + 22, 6 );
+		len = 28;
+		break;
+	}
+
+	// Queue report, on failure leave it pending for the next call
+	if ( !usb_keyboard_queue( report, tx_buf, len ) )
+	{
+		if ( !usb_keyboard_deferred[ report ] )
 		{
-			if ( usb_tx_packet_count( SYS_CTRL_ENDPOINT ) < TX_PACKET_LIMIT )
-			{
-				tx_packet = usb_malloc();
-				if ( tx_packet )
-					break;
-			}
+			usb_keyboard_deferred[ report ] = 1;
+			usb_keyboard_deferred_start[ report ] = Time_now();
 		}
 
 		// USB Timeout, drop the packet, and potentially try something more drastic to re-enable the bus
-		if ( Time_duration_ms( start ) > TX_TIMEOUT_MS || transmit_previous_timeout )
+		if ( Time_duration_ms( usb_keyboard_deferred_start[ report ] ) > TX_TIMEOUT_MS || transmit_previous_timeout )
 		{
 			transmit_previous_timeout = 1;
+			usb_keyboard_stats[ report ].dropped++;
+			usb_keyboard_deferred[ report ] = 0;
 			buffer->changed = USBKeyChangeState_None; // Indicate packet lost
 			#if enableDeviceRestartOnUSBTimeout == 1
 			warn_printNL("USB Transmit Timeout...restarting device");
@@ -169,21 +284,18 @@ void usb_keyboard_send( USBKeys *buffer, uint8_t protocol )
 			#else
 			warn_printNL("USB Transmit Timeout...auto-restart disabled");
 			#endif
-			// Try to wakeup
-			return;
+			return 1;
 		}
 
-		yield();
+		return 0;
 	}
 
 	transmit_previous_timeout = 0;
+	usb_keyboard_deferred[ report ] = 0;
 
-	// Pointer to USB tx packet buffer
-	uint8_t *tx_buf = tx_packet->buf;
-
-	// Check system control and consumer control keys
-	if ( buffer->changed & USBKeyChangeState_System || buffer->changed & USBKeyChangeState_Consumer )
+	switch ( report )
 	{
+	case USBKeyboardReport_SysCtrl:
 		if ( Output_DebugMode )
 		{
 			USB_SysCtrlDebug( buffer );
@@ -194,22 +306,11 @@ void usb_keyboard_send( USBKeys *buffer, uint8_t protocol )
 		USBKeys_idle.sys_ctrl = buffer->sys_ctrl;
 		USBKeys_idle.cons_ctrl = buffer->cons_ctrl;
 
-		*tx_buf++ = (uint8_t)(buffer->cons_ctrl & 0x00FF);
-		*tx_buf++ = (uint8_t)(buffer->cons_ctrl >> 8);
-		*tx_buf   = buffer->sys_ctrl - 0x80;
-		tx_packet->len = 3;
-
-		// Send USB Packet
-		usb_tx( SYS_CTRL_ENDPOINT, tx_packet );
 		buffer->changed &= ~USBKeyChangeState_System; // Mark sent
 		buffer->changed &= ~USBKeyChangeState_Consumer; // Mark sent
-		return;
-	}
+		break;
 
-	switch ( protocol )
-	{
-	// Send boot keyboard interrupt packet(s)
-	case 0:
+	case USBKeyboardReport_Boot:
 		// USB Boot Mode debug output
 		if ( Output_DebugMode )
 		{
@@ -220,64 +321,26 @@ void usb_keyboard_send( USBKeys *buffer, uint8_t protocol )
 		memcpy( (void*)&USBKeys_idle.keys, buffer->keys, USB_BOOT_MAX_KEYS );
 		USBKeys_idle.modifiers = buffer->modifiers;
 
-		// Boot Mode
-		*tx_buf++ = buffer->modifiers;
-		*tx_buf++ = 0;
-		memcpy( tx_buf, buffer->keys, USB_BOOT_MAX_KEYS );
-		tx_packet->len = 8;
-
-		// Send USB Packet
-		usb_tx( KEYBOARD_ENDPOINT, tx_packet );
 		buffer->changed = USBKeyChangeState_None;
 		break;
 
-	// Send NKRO keyboard interrupts packet(s)
-	case 1:
+	default:
+		// USB NKRO Debug output
 		if ( Output_DebugMode )
 		{
 			dbug_print("NKRO USB: ");
+			USB_NKRODebug( buffer );
 		}
 
-		// Standard HID Keyboard
-		if ( buffer->changed )
-		{
-			// USB NKRO Debug output
-			if ( Output_DebugMode )
-			{
-				USB_NKRODebug( buffer );
-			}
-
-			// Store update for idle packet
-			memcpy( (void*)&USBKeys_idle.keys, buffer->keys, USB_NKRO_BITFIELD_SIZE_KEYS );
-			USBKeys_idle.modifiers = buffer->modifiers;
-
-			// Clear packet length
-			tx_packet->len = 0;
-
-			// Modifiers
-			*tx_buf++ = buffer->modifiers;
-			tx_packet->len += 1;
-
-			// 4-164 (first 21 bytes)
-			// 0-3 and 165-168 are masked by the descriptor (padding)
-			memcpy( tx_buf, buffer->keys, 21 );
-			tx_buf += 21;
-			tx_packet->len += 21;
-
-			// 176-221 (last 6 bytes)
-			// 222-223 are masked by the descriptor (padding)
-			memcpy( tx_buf, buffer->keys + 22, 6 );
-			tx_packet->len += 6;
-
-			// Send USB Packet
-			usb_tx( NKRO_KEYBOARD_ENDPOINT, tx_packet );
-			buffer->changed = USBKeyChangeState_None; // Mark sent
-		}
+		// Store update for idle packet
+		memcpy( (void*)&USBKeys_idle.keys, buffer->keys, USB_NKRO_BITFIELD_SIZE_KEYS );
+		USBKeys_idle.modifiers = buffer->modifiers;
 
+		buffer->changed = USBKeyChangeState_None; // Mark sent
 		break;
 	}
 
-	return;
+	return 1;
 }
 
 #endif
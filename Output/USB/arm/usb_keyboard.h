@@ -41,9 +41,38 @@
 
 
 
+// ----- Enumerations -----
+
+// Keyboard report queues (one per endpoint)
+typedef enum USBKeyboardReport {
+	USBKeyboardReport_Boot    = 0, // KEYBOARD_ENDPOINT
+	USBKeyboardReport_NKRO    = 1, // NKRO_KEYBOARD_ENDPOINT
+	USBKeyboardReport_SysCtrl = 2, // SYS_CTRL_ENDPOINT
+	USBKeyboardReport_Count,
+} USBKeyboardReport;
+
+
+
+// ----- Structs -----
+
+// Keyboard report queue counters
+typedef struct USBKeyboardReportStats {
+	uint32_t queued;    // Reports queued as a new packet
+	uint32_t coalesced; // Reports that overwrote a still pending report
+	uint32_t dropped;   // Reports discarded (host resume or transmit timeout)
+} USBKeyboardReportStats;
+
+
+
+// ----- Variables -----
+
+extern USBKeyboardReportStats usb_keyboard_stats[ USBKeyboardReport_Count ];
+
+
+
 // ----- Functions -----
 
 void usb_keyboard_idle_update();
-void usb_keyboard_send( USBKeys *buffer, uint8_t protocol );
+uint8_t usb_keyboard_send( USBKeys *buffer, uint8_t protocol );
 void usb_keyboard_clear( uint8_t protocol );
 
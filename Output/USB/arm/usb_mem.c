@@ -33,6 +33,7 @@
 
 // Project Includes
 #include <Lib/OutputLib.h>
+#include <kll_defs.h>
 
 // Local Includes
 #include "usb_dev.h"
@@ -46,16 +47,26 @@
 __attribute__ ((section(".usbbuffers"), used))
 unsigned char usb_buffer_memory[ NUM_USB_BUFFERS * sizeof(usb_packet_t) ];
 static uint32_t usb_buffer_available = 0xFFFFFFFF;
+static uint8_t usb_buffer_free = NUM_USB_BUFFERS;
+
+// Endpoint each buffer is accounted to (0 - unaccounted), and buffers held per endpoint
+static uint8_t usb_buffer_owner[ NUM_USB_BUFFERS ];
+static uint8_t usb_buffer_held[ NUM_ENDPOINTS + 1 ];
 
 #elif defined(_sam_)
 static usb_packet_t usb_packet;
 
 #endif
 
+// Pool statistics
+volatile uint8_t  USBMem_HighWater;                             // Most buffers in use at once
+volatile uint32_t USBMem_AllocFailures[ NUM_ENDPOINTS + 1 ];    // Failed allocations per endpoint (0 - unaccounted)
+
+
 
 // ----- Externs -----
 
-extern void usb_rx_memory( usb_packet_t *packet );
+extern uint8_t usb_rx_memory( usb_packet_t *packet );
 
 // for the receive endpoints to request memory
 extern uint8_t usb_rx_memory_needed;
@@ -64,27 +75,66 @@ extern uint8_t usb_rx_memory_needed;
 
 // ----- Functions -----
 
+#if defined(_kinetis_)
+// Check whether an endpoint may hold one more buffer
+// free is the number of unallocated buffers left once it does
+// Keyboard endpoints may dip into the reserve, every other endpoint must leave it untouched
+// Must be called with interrupts disabled
+static uint8_t usb_mem_allowed( uint32_t endpoint, uint8_t free )
+{
+	if ( endpoint == 0 )
+		return 1;
+
+	if ( usb_buffer_held[ endpoint ] >= USBEndpointQuota_define )
+		return 0;
+
+	switch ( endpoint )
+	{
+	case KEYBOARD_ENDPOINT:
+	case NKRO_KEYBOARD_ENDPOINT:
+	case SYS_CTRL_ENDPOINT:
+		return 1;
+	}
+
+	return free >= USBKeyboardReserve_define;
+}
+#endif
+
+
 // use bitmask and CLZ instruction to implement fast free list
 // http://www.archivum.info/gnu.gcc.help/2006-08/00148/Re-GCC-Inline-Assembly.html
 // http://gcc.gnu.org/ml/gcc/2012-06/msg00015.html
 // __builtin_clz()
 
-usb_packet_t *usb_malloc()
+// Allocate a buffer accounted to the given endpoint (0 - unaccounted, no quota)
+// Returns NULL if the pool is empty, the endpoint quota is used up, or only the keyboard reserve is left
+usb_packet_t *usb_malloc_endpoint( uint32_t endpoint )
 {
 #if defined(_kinetis_)
 	unsigned int n, avail;
 	uint8_t *p;
 
+	if ( endpoint > NUM_ENDPOINTS )
+		return NULL;
+
 	__disable_irq();
 	avail = usb_buffer_available;
 	n = __builtin_clz( avail ); // clz = count leading zeros
-	if ( n >= NUM_USB_BUFFERS )
+	if ( n >= NUM_USB_BUFFERS || !usb_mem_allowed( endpoint, usb_buffer_free - 1 ) )
 	{
+		USBMem_AllocFailures[ endpoint ]++;
 		__enable_irq();
 		return NULL;
 	}
 
 	usb_buffer_available = avail & ~(0x80000000 >> n);
+	usb_buffer_free--;
+	usb_buffer_owner[ n ] = endpoint;
+	usb_buffer_held[ endpoint ]++;
+	if ( NUM_USB_BUFFERS - usb_buffer_free > USBMem_HighWater )
+	{
+		USBMem_HighWater = NUM_USB_BUFFERS - usb_buffer_free;
+	}
 	__enable_irq();
 	p = usb_buffer_memory + ( n * sizeof(usb_packet_t) );
 	*(uint32_t *)p = 0;
@@ -97,6 +147,39 @@ usb_packet_t *usb_malloc()
 }
 
 
+usb_packet_t *usb_malloc()
+{
+	return usb_malloc_endpoint( 0 );
+}
+
+
+// Re-account an allocated buffer to a receive endpoint (used when handing a freed buffer to a starving endpoint)
+// Returns 1 if the endpoint may take the buffer, 0 if over quota/reserve
+// Must be called with interrupts disabled
+uint8_t usb_mem_assign( usb_packet_t *p, uint32_t endpoint )
+{
+#if defined(_kinetis_)
+	unsigned int n;
+
+	n = ( (uint8_t *)p - usb_buffer_memory ) / sizeof(usb_packet_t);
+	if ( n >= NUM_USB_BUFFERS || endpoint > NUM_ENDPOINTS )
+		return 0;
+
+	// The buffer is still allocated, so the free count does not change
+	if ( !usb_mem_allowed( endpoint, usb_buffer_free ) )
+		return 0;
+
+	usb_buffer_held[ usb_buffer_owner[ n ] ]--;
+	usb_buffer_owner[ n ] = endpoint;
+	usb_buffer_held[ endpoint ]++;
+	return 1;
+
+#else
+	return 1;
+#endif
+}
+
+
 void usb_free( usb_packet_t *p )
 {
 #if defined(_kinetis_)
@@ -106,18 +189,51 @@ void usb_free( usb_packet_t *p )
 	if ( n >= NUM_USB_BUFFERS )
 		return;
 
+	// Release from the owning endpoint
+	__disable_irq();
+	usb_buffer_held[ usb_buffer_owner[ n ] ]--;
+	usb_buffer_owner[ n ] = 0;
+	usb_buffer_held[ 0 ]++;
+	__enable_irq();
+
 	// if any endpoints are starving for memory to receive
 	// packets, give this memory to them immediately!
-	if ( usb_rx_memory_needed && usb_configuration )
+	// (only to endpoints within their quota, see usb_mem_assign)
+	if ( usb_rx_memory_needed && usb_configuration && usb_rx_memory( p ) )
 	{
-		usb_rx_memory( p );
 		return;
 	}
 
 	mask = (0x80000000 >> n);
 	__disable_irq();
+	usb_buffer_held[ 0 ]--;
 	usb_buffer_available |= mask;
+	usb_buffer_free++;
 	__enable_irq();
 #endif
 }
 
+
+// Number of buffers currently held by an endpoint (0 - unaccounted)
+uint8_t usb_mem_held( uint32_t endpoint )
+{
+#if defined(_kinetis_)
+	if ( endpoint > NUM_ENDPOINTS )
+		return 0;
+	return usb_buffer_held[ endpoint ];
+#else
+	return 0;
+#endif
+}
+
+
+// Number of unallocated buffers
+uint8_t usb_mem_free()
+{
+#if defined(_kinetis_)
+	return usb_buffer_free;
+#else
+	return 0;
+#endif
+}
+
@@ -36,6 +36,9 @@
 // Compiler Includes
 #include <stdint.h>
 
+// Local Includes
+#include "usb_desc.h"
+
 
 
 // ----- Structs -----
@@ -49,8 +52,20 @@ typedef struct usb_packet_struct {
 
 
 
+// ----- Variables -----
+
+extern volatile uint8_t  USBMem_HighWater;                          // Most buffers in use at once
+extern volatile uint32_t USBMem_AllocFailures[ NUM_ENDPOINTS + 1 ]; // Failed allocations per endpoint (0 - unaccounted)
+
+
+
 // ----- Functions -----
 
 usb_packet_t *usb_malloc();
+usb_packet_t *usb_malloc_endpoint( uint32_t endpoint );
+uint8_t usb_mem_assign( usb_packet_t *p, uint32_t endpoint );
 void usb_free( usb_packet_t *p );
 
+uint8_t usb_mem_held( uint32_t endpoint );
+uint8_t usb_mem_free();
+
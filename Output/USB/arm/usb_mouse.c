@@ -85,7 +85,7 @@ void usb_mouse_send()
 		// Attempt to acquire a USB packet for the mouse endpoint
 		if ( usb_tx_packet_count( MOUSE_ENDPOINT ) < TX_PACKET_LIMIT )
 		{
-			tx_packet = usb_malloc();
+			tx_packet = usb_malloc_endpoint( MOUSE_ENDPOINT );
 			if ( tx_packet )
 				break;
 		}
@@ -48,6 +48,15 @@
 
 
 
+// ----- Variables -----
+
+#if defined(_kinetis_)
+// Packet held by usb_rawio_rx_peek()
+static usb_packet_t *rx_peek_packet = 0;
+#endif
+
+
+
 // ----- Functions -----
 
 #if defined(_kinetis_)
@@ -99,6 +108,32 @@ int32_t usb_rawio_rx( void *buf, uint32_t timeout )
 	return RAWIO_RX_SIZE;
 }
 
+// Retrieve pointer to the next packet from host, without copying
+// The packet is held until usb_rawio_rx_release() is called
+// Returns 0 if there are no packets
+uint8_t *usb_rawio_rx_peek()
+{
+	// Error if USB isn't configured
+	if ( !usb_configuration )
+		return 0;
+
+	// Retrieve packet, unless one is already held
+	if ( !rx_peek_packet )
+		rx_peek_packet = usb_rx( RAWIO_RX_ENDPOINT );
+
+	return rx_peek_packet ? rx_peek_packet->buf : 0;
+}
+
+// Release packet retrieved by usb_rawio_rx_peek()
+void usb_rawio_rx_release()
+{
+	if ( rx_peek_packet )
+	{
+		usb_free( rx_peek_packet );
+		rx_peek_packet = 0;
+	}
+}
+
 // Send packet to host
 // XXX Only transfers RAWIO_TX_SIZE on each call (likely 64 bytes)
 // Always returns RAWIO_TX_SIZE
@@ -117,7 +152,7 @@ int32_t usb_rawio_tx( const void *buf, uint32_t timeout )
 		if ( usb_tx_packet_count( RAWIO_TX_ENDPOINT ) < TX_PACKET_LIMIT )
 		{
 			// Allocate a packet buffer
-			tx_packet = usb_malloc();
+			tx_packet = usb_malloc_endpoint( RAWIO_TX_ENDPOINT );
 			if ( tx_packet )
 				break;
 		}
@@ -156,6 +191,17 @@ int32_t usb_rawio_rx(void *buf, uint32_t timeout)
 	return -1;
 }
 
+// Retrieve pointer to the next packet from host
+// XXX (HaaTa): This is always 0, SAM4S has a callback function UDI_HID_GENERIC_REPORT_OUT to handle each packet
+uint8_t *usb_rawio_rx_peek()
+{
+	return 0;
+}
+
+void usb_rawio_rx_release()
+{
+}
+
 // Send packet to host
 // XXX Only transfers RAWIO_TX_SIZE on each call (likely 64 bytes)
 // Always returns RAWIO_TX_SIZE, unless there is a timeout or USB isn't configured
@@ -31,5 +31,7 @@
 
 uint32_t usb_rawio_available();
 int32_t  usb_rawio_rx( void *buf, uint32_t timeout );
+uint8_t *usb_rawio_rx_peek();
+void     usb_rawio_rx_release();
 int32_t  usb_rawio_tx( const void *buf, uint32_t timeout );
 
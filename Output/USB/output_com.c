@@ -124,6 +124,20 @@ int Output_rawio_getbuffer( char* buffer )
 }
 
 
+// USB RawIO peek buffer
+char* Output_rawio_peekbuffer()
+{
+	return USB_rawio_peekbuffer();
+}
+
+
+// USB RawIO release buffer
+void Output_rawio_releasebuffer()
+{
+	USB_rawio_releasebuffer();
+}
+
+
 // USB RawIO send buffer
 int Output_rawio_sendbuffer( char* buffer )
 {
@@ -31,6 +31,7 @@
 #include <led.h>
 #include <print.h>
 #include <scan_loop.h>
+#include <trace.h>
 
 // USB Includes
 #if defined(_avr_at_)
@@ -84,6 +85,7 @@ void cliFunc_usbAddr    ( char* args );
 void cliFunc_usbConf    ( char* args );
 void cliFunc_usbInitTime( char* args );
 void cliFunc_usbErrors  ( char* args );
+void cliFunc_usbReports ( char* args );
 
 
 
@@ -96,7 +98,8 @@ CLIDict_Entry( readLEDs,    "Read LED byte:" NL "\t\t1 NumLck, 2 CapsLck, 4 Scrl
 CLIDict_Entry( usbAddr,     "Shows the negotiated USB unique Id, given to device by host." );
 CLIDict_Entry( usbConf,     "Shows whether USB is configured or not." );
 CLIDict_Entry( usbInitTime, "Displays the time in ms from usb_init() till the last setup call." );
-CLIDict_Entry( usbErrors,   "Displays number of usb errors since startup." );
+CLIDict_Entry( usbErrors,   "Displays number of usb errors and packet buffer pool stats since startup." );
+CLIDict_Entry( usbReports,  "Displays queued/coalesced/dropped keyboard reports per endpoint since startup." );
 
 CLIDict_Def( usbCLIDict, "USB Module Commands" ) = {
 	CLIDict_Item( idle ),
@@ -106,6 +109,7 @@ CLIDict_Def( usbCLIDict, "USB Module Commands" ) = {
 	CLIDict_Item( usbConf ),
 	CLIDict_Item( usbInitTime ),
 	CLIDict_Item( usbErrors ),
+	CLIDict_Item( usbReports ),
 	{ 0, 0, 0 } // Null entry for dictionary end
 };
 
@@ -159,6 +163,10 @@ volatile static uint8_t Output_reset_schedule;
 // Latency measurement resource
 static uint8_t outputPeriodicLatencyResource;
 static uint8_t outputPollLatencyResource;
+static uint8_t outputReportAgeLatencyResource;
+
+// Set while a queued HID report is waiting for the next SOF
+static volatile uint8_t USB_reportPending;
 
 
 
@@ -587,6 +595,8 @@ void Output_usbCodeSend_capability( TriggerMacro *trigger, uint8_t state, uint8_
 		break;
 	}
 
+	// Attribute report change to the traced key event
+	Trace_report();
 #endif
 }
 
@@ -823,6 +833,31 @@ inline void USB_setup()
 	// Latency resource allocation
 	outputPeriodicLatencyResource = Latency_add_resource("USBOutputPeri", LatencyOption_Ticks);
 	outputPollLatencyResource = Latency_add_resource("USBOutputPoll", LatencyOption_Ticks);
+	outputReportAgeLatencyResource = Latency_add_resource("USBReportAge", LatencyOption_us);
+}
+
+
+// Called whenever a HID report is queued
+// Measures from the oldest report waiting for the next SOF
+void USB_reportQueued()
+{
+	if ( !USB_reportPending )
+	{
+		Latency_start_time( outputReportAgeLatencyResource );
+		USB_reportPending = 1;
+	}
+}
+
+
+// Called on each USB SOF (from the USB ISR)
+// Records how long the queued report waited for the frame it will be sent in
+void USB_reportSOF()
+{
+	if ( USB_reportPending )
+	{
+		Latency_end_time( outputReportAgeLatencyResource );
+		USB_reportPending = 0;
+	}
 }
 
 
@@ -993,9 +1028,17 @@ inline void USB_periodic()
 	}
 
 	// Send keypresses while there are pending changes
+	// Reports that cannot be queued yet stay pending until the next periodic call
 	while ( USBKeys_primary.changed && USB_ready() )
 	{
-		usb_keyboard_send( (USBKeys*)&USBKeys_primary, USBKeys_Protocol );
+		if ( !usb_keyboard_send( (USBKeys*)&USBKeys_primary, USBKeys_Protocol ) )
+			break;
+	}
+
+	// Record latency of traced key events once the report has been sent
+	if ( !USBKeys_primary.changed )
+	{
+		Trace_reportSent();
 	}
 
 	// Signal Scan Module we are finished
@@ -1184,6 +1227,28 @@ int USB_rawio_getbuffer( char* buffer )
 }
 
 
+// USB RawIO peek buffer
+// Returns a pointer into the USB receive packet, without copying
+// The packet is held until USB_rawio_releasebuffer is called
+char* USB_rawio_peekbuffer()
+{
+#if enableRawIO_define == 1
+	return (char*)usb_rawio_rx_peek();
+#else
+	return 0;
+#endif
+}
+
+
+// USB RawIO release buffer
+void USB_rawio_releasebuffer()
+{
+#if enableRawIO_define == 1
+	usb_rawio_rx_release();
+#endif
+}
+
+
 // USB RawIO send buffer
 // XXX Must be a 64 byte buffer
 int USB_rawio_sendbuffer( char* buffer )
@@ -1300,5 +1365,51 @@ void cliFunc_usbErrors( char* args )
 	print(NL);
 	info_print("USB Frame Errors: ");
 	printInt32( USBStatus_FrameErrors );
+
+#if defined(_kinetis_)
+	// Packet buffer pool usage, to help tune NUM_USB_BUFFERS and quotas
+	print(NL);
+	info_print("USB Buffers: ");
+	printInt8( usb_mem_free() );
+	print(" free, ");
+	printInt8( USBMem_HighWater );
+	print(" high water (of ");
+	printInt8( NUM_USB_BUFFERS );
+	print(")");
+
+	print(NL);
+	info_print("USB Alloc Failures (Endpoint - Failures/Held):");
+	for ( uint8_t endpoint = 0; endpoint <= NUM_ENDPOINTS; endpoint++ )
+	{
+		print(NL "\t");
+		printInt8( endpoint );
+		print(" - ");
+		printInt32( USBMem_AllocFailures[ endpoint ] );
+		print("/");
+		printInt8( usb_mem_held( endpoint ) );
+	}
+#endif
+}
+
+
+void cliFunc_usbReports( char* args )
+{
+#if enableKeyboard_define == 1 && ( defined(_kinetis_) || defined(_sam_) )
+	const char *names[] = { "Boot:    ", "NKRO:    ", "SysCtrl: " };
+
+	print(NL);
+	info_print("Keyboard Reports");
+	for ( uint8_t report = 0; report < USBKeyboardReport_Count; report++ )
+	{
+		print(NL "\t");
+		print( names[ report ] );
+		print("Queued: ");
+		printInt32( usb_keyboard_stats[ report ].queued );
+		print(" Coalesced: ");
+		printInt32( usb_keyboard_stats[ report ].coalesced );
+		print(" Dropped: ");
+		printInt32( usb_keyboard_stats[ report ].dropped );
+	}
+#endif
 }
 
@@ -153,6 +153,9 @@ void USB_periodic();
 
 void USB_flushBuffers();
 
+void USB_reportQueued();
+void USB_reportSOF();
+
 void USB_firmwareReload(); // Request firmware reload
 void USB_softReset();      // Request soft reset
 
@@ -164,6 +167,8 @@ int USB_putstr( char* str );
 
 unsigned int USB_rawio_availablechar();
 int USB_rawio_getbuffer( char* buffer );
+char* USB_rawio_peekbuffer();
+void USB_rawio_releasebuffer();
 int USB_rawio_sendbuffer( char* buffer );
 
 void USB_ConsCtrlDebug( USBKeys *buffer );
@@ -177,6 +177,26 @@ int Output_rawio_getbuffer( char* buffer )
 }
 
 
+// USB RawIO peek buffer
+char* Output_rawio_peekbuffer()
+{
+#if enableRawIO_define == 1
+	return USB_rawio_peekbuffer();
+#else
+	return 0;
+#endif
+}
+
+
+// USB RawIO release buffer
+void Output_rawio_releasebuffer()
+{
+#if enableRawIO_define == 1
+	USB_rawio_releasebuffer();
+#endif
+}
+
+
 // USB RawIO send buffer
 int Output_rawio_sendbuffer( char* buffer )
 {
@@ -39,6 +39,9 @@
 
 volatile I2C_Channel i2c_channels[ISSI_I2C_Buses_define];
 
+// Transaction queue of each bus (see i2c_queue_sequence)
+static I2C_Transaction i2c_queues[ISSI_I2C_Buses_define][ISSI_I2C_QueueSize_define];
+
 #if defined(_kinetis_)
 uint32_t i2c_offset[] = {
 	0x0,    // Bus 0
@@ -53,6 +56,7 @@ Twi *twi_devs[] = {
 // ----- Functions -----
 
 void i2c_isr( uint8_t ch );
+static void i2c_queue_next( uint8_t ch );
 
 // Initialize error counters
 void i2c_initial()
@@ -260,6 +264,9 @@ void i2c_reset()
 	{
 		volatile I2C_Channel *channel = &( i2c_channels[ch - ISSI_I2C_FirstBus_define] );
 		channel->status = I2C_AVAILABLE;
+
+		// Drop queued transactions
+		channel->queue_head = channel->queue_tail;
 	}
 
 	i2c_setup(0);
@@ -412,6 +419,73 @@ i2c_send_sequence_cleanup:
 	return result;
 }
 
+int32_t i2c_queue_sequence(
+	uint8_t ch,
+	uint16_t *sequence,
+	uint32_t sequence_length,
+	uint8_t *received_data,
+	void ( *callback_fn )( void* ),
+	void *user_data
+) {
+	volatile I2C_Channel *channel = &( i2c_channels[ch - ISSI_I2C_FirstBus_define] );
+
+	// Check for a full queue
+	uint8_t tail = channel->queue_tail;
+	uint8_t next = tail + 1 >= ISSI_I2C_QueueSize_define ? 0 : tail + 1;
+	if ( next == channel->queue_head )
+	{
+		return -1;
+	}
+
+	// Add transaction, then make it visible to the ISR
+	I2C_Transaction *transaction = &i2c_queues[ch - ISSI_I2C_FirstBus_define][tail];
+	transaction->sequence = sequence;
+	transaction->sequence_length = sequence_length;
+	transaction->received_data = received_data;
+	transaction->callback_fn = callback_fn;
+	transaction->user_data = user_data;
+	channel->queue_tail = next;
+
+	// Start sending if the bus is idle
+	// Otherwise the ISR starts the transaction once the current one has finished
+	// (the ISR only runs while the bus is busy, so it cannot start the transaction at the same time)
+	if ( channel->status == I2C_AVAILABLE )
+	{
+		i2c_queue_next( ch );
+	}
+
+	return 0;
+}
+
+// Start the next queued transaction, if any
+static void i2c_queue_next( uint8_t ch )
+{
+	volatile I2C_Channel *channel = &( i2c_channels[ch - ISSI_I2C_FirstBus_define] );
+
+	uint8_t head = channel->queue_head;
+	if ( head == channel->queue_tail )
+	{
+		return;
+	}
+	channel->queue_head = head + 1 >= ISSI_I2C_QueueSize_define ? 0 : head + 1;
+
+	I2C_Transaction *transaction = &i2c_queues[ch - ISSI_I2C_FirstBus_define][head];
+	if ( i2c_send_sequence(
+		ch,
+		transaction->sequence,
+		transaction->sequence_length,
+		transaction->received_data,
+		transaction->callback_fn,
+		transaction->user_data
+	) == -1 )
+	{
+		// Failed to start (e.g. arbitration lost), the callback will never be called
+		// Drop the rest of the queue and leave the bus errored, the owner recovers using i2c_error()/i2c_reset()
+		channel->queue_head = channel->queue_tail;
+		channel->status = I2C_ERROR;
+	}
+}
+
 
 void i2c_isr( uint8_t ch )
 {
@@ -675,7 +749,9 @@ i2c_isr_stop:
 	channel->status = I2C_AVAILABLE;
 
 	// Call the user-supplied callback function upon successful completion (if it exists).
-	if ( channel->callback_fn )
+	// Then start the next queued transaction
+	uint8_t queued = channel->queue_head != channel->queue_tail;
+	if ( channel->callback_fn || queued )
 	{
 		// Delay before starting linked function
 #if ISSI_Chip_31FL3731_define == 1 || ISSI_Chip_31FL3732_define == 1
@@ -683,8 +759,17 @@ i2c_isr_stop:
 #elif ISSI_Chip_31FL3733_define == 1 || ISSI_Chip_31FL3736_define == 1
 		delay_us(10);
 #endif
+	}
+	if ( channel->callback_fn )
+	{
 		( *channel->callback_fn )( channel->user_data );
 	}
+
+	// Callback may have started a new sequence
+	if ( queued && channel->status == I2C_AVAILABLE )
+	{
+		i2c_queue_next( ch );
+	}
 	return;
 
 i2c_isr_error:
@@ -54,10 +54,21 @@ typedef struct {
 	uint8_t reads_ahead;
 	uint8_t status;
 	uint8_t txrx;
+	uint8_t queue_head; // Next queued transaction to send (only modified when the bus is idle, or from the ISR)
+	uint8_t queue_tail; // Next free queue entry (only modified by i2c_queue_sequence)
 	uint32_t error_count;
 	uint32_t last_error;
 } I2C_Channel;
 
+// Queued transaction, see i2c_queue_sequence
+typedef struct {
+	uint16_t *sequence;
+	uint8_t *received_data;
+	void (*callback_fn)(void*);
+	void *user_data;
+	uint16_t sequence_length;
+} I2C_Transaction;
+
 
 
 // ----- Functions -----
@@ -104,11 +115,32 @@ int32_t i2c_send_sequence(
 	void *user_data
 );
 
+/*
+ * Queues a sequence, same arguments as i2c_send_sequence.
+ *
+ * Queued sequences are sent back-to-back from the interrupt handler, each bus has its own queue so multiple buses are
+ * sent concurrently. The sequence (and received_data) must remain valid until the callback_fn is called.
+ *
+ * Returns -1 if the queue is full. If the bus is in an error state, the sequence is queued but not sent until
+ * i2c_reset() is called (which also clears the queues). If a queued sequence fails to start, the bus is put into
+ * the error state and the rest of the queue is dropped (callbacks are not called).
+ */
+int32_t i2c_queue_sequence(
+	uint8_t ch,
+	uint16_t *sequence,
+	uint32_t sequence_length,
+	uint8_t *received_data,
+	void (*callback_fn)(void*),
+	void *user_data
+);
+
 /*
  * Convenience macros
  */
 #define i2c_send(ch, seq, seq_len)      i2c_send_sequence( ch, seq, seq_len, 0, 0, 0 )
 #define i2c_read(ch, seq, seq_len, rec) i2c_send_sequence( ch, seq, seq_len, rec, 0, 0 )
+#define i2c_queue(ch, seq, seq_len, callback_fn, user_data) \
+	i2c_queue_sequence( ch, seq, seq_len, 0, callback_fn, user_data )
 
 /*
  * Check if busy
@@ -172,6 +172,9 @@
 
 #define LED_TotalChannels     (LED_BufferLength * ISSI_Chips_define)
 
+// Bitmask of every ISSI chip
+#define LED_ChipsAll          ((1 << ISSI_Chips_define) - 1)
+
 
 
 // ----- Macros -----
@@ -274,13 +277,16 @@ static StorageModule LedStorage = {
 };
 #endif
 
-#if ISSI_Chip_31FL3731_define == 1
-// Emulated brightness buffer
-volatile LED_Buffer LED_pageBuffer_brightness[ISSI_Chips_define];
-#endif
 extern LED_Buffer LED_pageBuffer[ISSI_Chips_define];
 
+// Double buffering
+// PixelMap processes the next frame into one set of page buffers while the other set is being sent
+LED_Buffer LED_pageBufferBack[ISSI_Chips_define];
+volatile LED_Buffer *LED_pageSend; // Page buffers currently being sent
+
 uint8_t LED_displayFPS;     // Display fps to cli
+uint32_t LED_framesSent;      // Frames sent since the fps display was enabled
+uint32_t LED_framesOverlapped; // Frames processed while the previous frame was being sent
 uint8_t LED_enable;         // Enable/disable ISSI chips
 uint8_t LED_enable_current; // Enable/disable ISSI chips (based on USB current availability)
 uint8_t LED_pause;          // Pause ISSI updates
@@ -288,6 +294,20 @@ uint8_t LED_brightness;     // Global brightness for LEDs
 
 uint32_t LED_framerate;     // Configured led framerate, given in ms per frame
 
+// Chips with modified PWM buffers that need to be sent
+// PixelMap LED_Buffers are mapped one-to-one to ISSI chips
+uint8_t LED_chipUpdate;
+
+// Number of I2C buses still sending the current frame
+volatile uint8_t LED_busesSending;
+
+// Page select sequences of each chip (PWM page), queued before each PWM buffer
+// IS31FL3733 requires unlocking the 0xFD register
+#if ISSI_Chip_31FL3733_define == 1 || ISSI_Chip_31FL3736_define == 1
+uint16_t LED_pageUnlock[ISSI_Chips_define][3];
+#endif
+uint16_t LED_pageSelect[ISSI_Chips_define][3];
+
 Time LED_timePrev; // Last frame processed
 
 
@@ -324,6 +344,11 @@ const LED_EnableBuffer LED_ledEnableMask[ISSI_Chips_define] = {
 #error "Invalid number of ISSI Chips"
 #endif
 
+// A frame queues up to 3 transactions per chip (one queue entry is always kept free)
+#if ISSI_I2C_QueueSize_define <= ISSI_Chips_define * 3
+#error "ISSI_I2C_QueueSize must be larger than 3 x ISSI_Chips"
+#endif
+
 // GPIO Pins
 static const GPIO_Pin hardware_shutdown_pin = ISSI_HardwareShutdownPin_define;
 #if ISSI_Chip_31FL3733_define == 1 || ISSI_Chip_31FL3736_define == 1
@@ -414,34 +439,61 @@ void LED_sendPage( uint8_t bus, uint8_t addr, uint16_t *buffer, uint32_t len, ui
 }
 
 // Write register on all ISSI chips
-// Prepare pages first, then attempt write register with a minimal delay between chips
+// Prepare pages first, then write register with a minimal delay between chips
+// Transactions are queued, each bus is sent concurrently
 void LED_syncReg( uint8_t reg, uint8_t val, uint8_t page )
 {
-	// Setup each of the pages
-	for ( uint8_t ch = 0; ch < ISSI_Chips_define; ch++ )
+#if ISSI_Chip_31FL3733_define == 1 || ISSI_Chip_31FL3736_define == 1
+	uint16_t pageEnable[ISSI_Chips_define][3];
+#endif
+	uint16_t pageSetup[ISSI_Chips_define][3];
+	uint16_t writeData[ISSI_Chips_define][3];
+
+	// Wait for any frame still being sent, so the page select and register write queue back-to-back
+	// (an errored bus is not busy, its queue is dropped by the LED_scan recovery)
+	while ( i2c_any_busy() )
+		delay_us( ISSI_SendDelay );
+
+	// Bus needs to be reset first (see LED_scan)
+	if ( i2c_error() )
 	{
-		LED_setupPage(
-			LED_ChannelMapping[ ch ].bus,
-			LED_ChannelMapping[ ch ].addr,
-			page
-		);
+		warn_printNL("I2C error, register sync skipped");
+		return;
 	}
 
-	// Reg Write Setup
-	uint16_t writeData[] = { 0, reg, val };
-
-	// Write to all the registers
+	// The #error on ISSI_I2C_QueueSize guarantees all the transactions fit into the (now empty) queues
+	// Stop queueing if that still fails, sequences are on the stack and must not be queued after returning
 	for ( uint8_t ch = 0; ch < ISSI_Chips_define; ch++ )
 	{
-		writeData[0] = LED_ChannelMapping[ ch ].addr;
+		uint8_t addr = LED_ChannelMapping[ ch ].addr;
 		uint8_t bus = LED_ChannelMapping[ ch ].bus;
 
-		// Delay very little to help with synchronization
-		while ( i2c_send( bus, writeData, sizeof( writeData ) / 2 ) == -1 )
-			delay_us(10);
+#if ISSI_Chip_31FL3733_define == 1 || ISSI_Chip_31FL3736_define == 1
+		pageEnable[ ch ][0] = addr;
+		pageEnable[ ch ][1] = 0xFE;
+		pageEnable[ ch ][2] = 0xC5;
+		if ( i2c_queue( bus, pageEnable[ ch ], 3, 0, 0 ) == -1 )
+			goto sync_wait;
+#endif
+		pageSetup[ ch ][0] = addr;
+		pageSetup[ ch ][1] = 0xFD;
+		pageSetup[ ch ][2] = page;
+		if ( i2c_queue( bus, pageSetup[ ch ], 3, 0, 0 ) == -1 )
+			goto sync_wait;
 	}
 
-	// Delay until written
+	// Write to all the registers
+	for ( uint8_t ch = 0; ch < ISSI_Chips_define; ch++ )
+	{
+		writeData[ ch ][0] = LED_ChannelMapping[ ch ].addr;
+		writeData[ ch ][1] = reg;
+		writeData[ ch ][2] = val;
+		if ( i2c_queue( LED_ChannelMapping[ ch ].bus, writeData[ ch ], 3, 0, 0 ) == -1 )
+			goto sync_wait;
+	}
+
+sync_wait:
+	// Delay until written (sequences must remain valid until sent)
 	while ( i2c_any_busy() )
 		delay_us( ISSI_SendDelay );
 }
@@ -519,6 +571,10 @@ uint8_t LED_readReg( uint8_t bus, uint8_t addr, uint8_t reg, uint8_t page )
 
 void LED_reset()
 {
+	// Let any queued frame finish before re-initializing the bus
+	while ( i2c_any_busy() )
+		delay_us( ISSI_SendDelay );
+
 	// Initialize I2C in fast mode
 	i2c_setup(1);
 
@@ -585,6 +641,7 @@ void LED_reset()
 		for ( uint8_t reg = 0; reg < LED_EnableBufferLength; reg++ )
 		{
 			LED_pageBuffer[ ch ].ledctrl[ reg ] =  LED_ledEnableMask[ ch ].buffer[ reg ];
+			LED_pageBufferBack[ ch ].ledctrl[ reg ] =  LED_ledEnableMask[ ch ].buffer[ reg ];
 		}
 #endif
 	}
@@ -669,6 +726,9 @@ void LED_reset()
 	// Force PixelMap to be ready for the next frame
 	Pixel_FrameState = FrameState_Update;
 
+	// Chips have been reset, send every buffer on the next frame
+	LED_chipUpdate = LED_ChipsAll;
+
 	// Un-pause ISSI processing
 	LED_pause = 0;
 }
@@ -778,24 +838,26 @@ inline void LED_setup()
 	LED_pageBuffer[3].reg_addr = ISSI_LEDPwmRegStart;
 #endif
 
-	// Brightness emulation
-#if ISSI_Chip_31FL3731_define
-	// Setup LED_pageBuffer addresses and brightness section
-	LED_pageBuffer_brightness[0].i2c_addr = LED_MapCh1_Addr_define;
-	LED_pageBuffer_brightness[0].reg_addr = ISSI_LEDPwmRegStart;
-#if ISSI_Chips_define >= 2
-	LED_pageBuffer_brightness[1].i2c_addr = LED_MapCh2_Addr_define;
-	LED_pageBuffer_brightness[1].reg_addr = ISSI_LEDPwmRegStart;
-#endif
-#if ISSI_Chips_define >= 3
-	LED_pageBuffer_brightness[2].i2c_addr = LED_MapCh3_Addr_define;
-	LED_pageBuffer_brightness[2].reg_addr = ISSI_LEDPwmRegStart;
-#endif
-#if ISSI_Chips_define >= 4
-	LED_pageBuffer_brightness[3].i2c_addr = LED_MapCh4_Addr_define;
-	LED_pageBuffer_brightness[3].reg_addr = ISSI_LEDPwmRegStart;
-#endif
+	// Setup back page buffers, PixelMap LED_Buffers are mapped one-to-one to ISSI chips
+	// PixelMap updates LED_pageBuffer first
+	// Setup page select sequences
+	for ( uint8_t ch = 0; ch < ISSI_Chips_define; ch++ )
+	{
+		uint8_t addr = LED_ChannelMapping[ ch ].addr;
+#if ISSI_Chip_31FL3733_define == 1 || ISSI_Chip_31FL3736_define == 1
+		LED_pageUnlock[ ch ][0] = addr;
+		LED_pageUnlock[ ch ][1] = 0xFE;
+		LED_pageUnlock[ ch ][2] = 0xC5;
 #endif
+		LED_pageSelect[ ch ][0] = addr;
+		LED_pageSelect[ ch ][1] = 0xFD;
+		LED_pageSelect[ ch ][2] = ISSI_LEDPwmPage;
+
+		LED_pageBufferBack[ ch ].i2c_addr = LED_pageBuffer[ ch ].i2c_addr;
+		LED_pageBufferBack[ ch ].reg_addr = LED_pageBuffer[ ch ].reg_addr;
+		Pixel_setBackBuffer( ch, (void*)LED_pageBufferBack[ ch ].buffer );
+	}
+	LED_pageSend = LED_pageBufferBack;
 
 	// LED default setting
 	LED_enable = ISSI_Enable_define;
@@ -809,76 +871,97 @@ inline void LED_setup()
 }
 
 
-// LED Linked Send
-// Call-back for i2c write when updating led display
-// TODO Optimize linked send for multiple i2c buses
-uint8_t LED_chipSend;
-void LED_linkedSend()
+// LED Frame Sent
+// Called from the I2C ISR once a bus has sent the last queued transaction of the frame
+static void LED_frameSent( void *data )
+{
+	// Wait for the remaining buses
+	if ( --LED_busesSending )
+	{
+		return;
+	}
+
+	// Now ready to update the frame buffer (or send the next frame if already processed)
+	Pixel_frameSent();
+
+	// Initialize I2C in fast mode
+	i2c_setup(1);
+}
+
+// LED Frame Reset
+// Drops any queued transactions and restarts the Frame State, every chip is resent on the next frame
+static void LED_frameReset()
+{
+	i2c_reset();
+	LED_busesSending = 0;
+	Pixel_FrameState = FrameState_Update;
+
+	// Chip contents are unknown, resend everything
+	LED_chipUpdate = LED_ChipsAll;
+}
+
+// LED Frame Send
+// Queues the page select and PWM writes of all the modified ISSI chips
+// Each bus is sent concurrently from the I2C ISR, LED_frameSent is called when all buses have finished
+// Never waits on the I2C buses, the buses must be idle (see LED_scan) so the frame fits into the queues
+// If a bus errors or a queue is full anyway, the frame is dropped and retried by the next LED_scan
+static void LED_frameSend()
 {
 	// Initialize I2C in slow mode
 	i2c_setup(0);
 
-	// Check if we've updated all the ISSI chips for this frame
-	if ( LED_chipSend >= ISSI_Chips_define )
+	// Determine the last modified chip of each bus, it signals the end of the frame on that bus
+	uint8_t last[ISSI_I2C_Buses_define];
+	uint8_t buses = 0;
+	for ( uint8_t ch = 0; ch < ISSI_Chips_define; ch++ )
 	{
-		// Now ready to update the frame buffer
-		Pixel_FrameState = FrameState_Update;
-
-		// Initialize I2C in fast mode
-		i2c_setup(1);
+		if ( !( LED_chipUpdate & (1 << ch) ) )
+		{
+			continue;
+		}
 
-		// Finished sending the buffer, exit linked send
-		return;
+		uint8_t bus = LED_ChannelMapping[ ch ].bus - ISSI_I2C_FirstBus_define;
+		buses |= 1 << bus;
+		last[bus] = ch;
 	}
+	LED_busesSending = __builtin_popcount( buses );
 
-	// Update ISSI Frame State
-	Pixel_FrameState = FrameState_Sending;
+	// Queue each of the modified chips
+	for ( uint8_t ch = 0; ch < ISSI_Chips_define; ch++ )
+	{
+		if ( !( LED_chipUpdate & (1 << ch) ) )
+		{
+			continue;
+		}
 
-	// Lookup bus number
-	uint8_t bus = LED_ChannelMapping[ LED_chipSend ].bus;
+		uint8_t bus = LED_ChannelMapping[ ch ].bus;
 
-	/*
-	// Debug
-	dbug_print("Linked Send: chip(");
-	printHex( LED_chipSend );
-	print(")addr(");
-	printHex( LED_pageBuffer[ LED_chipSend ].i2c_addr );
-	print(")reg(");
-	printHex( LED_pageBuffer[ LED_chipSend ].reg_addr );
-	print(")len(");
-	printHex( sizeof( LED_Buffer ) / 2 );
-	print(")data[](");
-	//for ( uint8_t c = 0; c < 9; c++ )
-	for ( uint8_t c = 0; c < sizeof( LED_Buffer ) / 2 - 2; c++ )
-	{
-		printHex( LED_pageBuffer[ LED_chipSend ].buffer[c] );
-		print(" ");
+		// Page Setup
+#if ISSI_Chip_31FL3733_define == 1 || ISSI_Chip_31FL3736_define == 1
+		if ( i2c_error() || i2c_queue( bus, LED_pageUnlock[ ch ], 3, 0, 0 ) == -1 )
+			goto frame_abort;
+#endif
+		if ( i2c_error() || i2c_queue( bus, LED_pageSelect[ ch ], 3, 0, 0 ) == -1 )
+			goto frame_abort;
+
+		// PixelMap writes directly into the page buffer (brightness emulation included)
+		if ( i2c_error() || i2c_queue(
+			bus,
+			(uint16_t*)&LED_pageSend[ ch ],
+			sizeof( LED_Buffer ) / 2,
+			last[ bus - ISSI_I2C_FirstBus_define ] == ch ? LED_frameSent : 0,
+			0
+		) == -1 )
+			goto frame_abort;
 	}
-	print("..)" NL);
-	*/
 
-	// Artificial delay to assist i2c bus
-	const uint32_t delay_tm = ISSI_SendDelay;
-	//delay_us( delay_tm );
+	// All modified chips have been queued
+	LED_chipUpdate = 0;
+	return;
 
-	// Send, and recursively call this function when finished
-	while ( i2c_send_sequence(
-		bus,
-#if ISSI_Chip_31FL3731_define == 1
-		/* Brightness emulation */
-		(uint16_t*)&LED_pageBuffer_brightness[ LED_chipSend ],
-#else
-		(uint16_t*)&LED_pageBuffer[ LED_chipSend ],
-#endif
-		sizeof( LED_Buffer ) / 2,
-		0,
-		LED_linkedSend,
-		0
-	) == -1 )
-		delay_us( delay_tm );
-
-	// Increment chip position
-	LED_chipSend++;
+frame_abort:
+	// The last transaction of a bus (LED_frameSent) may not have been queued, the frame would never finish
+	LED_frameReset();
 }
 
 
@@ -934,19 +1017,22 @@ inline void LED_scan()
 	// Reset the buses and restart the Frame State
 	if ( i2c_error() )
 	{
-		i2c_reset();
-		Pixel_FrameState = FrameState_Update;
+		LED_frameReset();
 	}
 
 	// Only start if we haven't already
 	// And if we've finished updating the buffers
-	if ( Pixel_FrameState == FrameState_Sending )
+	if ( Pixel_FrameState == FrameState_Sending || Pixel_FrameState == FrameState_Queued )
 		goto led_finish_scan;
 
 	// Only send frame to ISSI chip if buffers are ready
 	if ( Pixel_FrameState != FrameState_Ready )
 		goto led_finish_scan;
 
+	// Wait for the buses to finish any other transactions (e.g. LED_syncReg), the frame is retried on the next scan
+	if ( i2c_any_busy() )
+		goto led_finish_scan;
+
 	// Adjust frame rate (i.e. delay and do something else for a bit)
 	Time duration = Time_duration( LED_timePrev );
 	if ( duration.ms < LED_framerate )
@@ -962,6 +1048,14 @@ inline void LED_scan()
 		printInt32( duration.ticks );
 		print(" ticks");
 
+		// Frames processed while the previous frame was being sent
+		LED_framesSent++;
+		LED_framesOverlapped += Pixel_frameOverlapped();
+		print(" - overlap ");
+		printInt32( LED_framesOverlapped );
+		print("/");
+		printInt32( LED_framesSent );
+
 		// Check if we're not meeting frame rate
 		if ( duration.ms > LED_framerate )
 		{
@@ -973,52 +1067,35 @@ inline void LED_scan()
 	}
 
 	// Emulated brightness control
-	// Lower brightness by LED_brightness
+	// Lower brightness by LED_brightness, applied by PixelMap while updating the page buffers
+	// All channels are updated on the next frame when changed
 #if ISSI_Chip_31FL3731_define == 1
-	for ( uint8_t chip = 0; chip < ISSI_Chips_define; chip++ )
-	{
-		for ( uint8_t ch = 0; ch < LED_EnableBufferLength; ch++ )
-		{
-			LED_pageBuffer_brightness[ chip ].ledctrl[ ch ] = LED_pageBuffer[ chip ].ledctrl[ ch ];
-		}
-
-		for ( uint8_t ch = 0; ch < LED_BufferLength; ch++ )
-		{
-			// Don't modify is 0
-			if ( LED_pageBuffer[ chip ].buffer[ ch ] == 0 || LED_brightness == 0 )
-			{
-				LED_pageBuffer_brightness[ chip ].buffer[ ch ] = 0;
-				continue;
-			}
-
-			// XXX (HaaTa) Yes, this is a bit slow, but it's pretty accurate
-			LED_pageBuffer_brightness[ chip ].buffer[ ch ] =
-				(LED_pageBuffer[ chip ].buffer[ ch ] * LED_brightness) / 0xFF;
-		}
-	}
+	Pixel_setOutputBrightness( LED_brightness );
 #endif
 
+	// Determine which chips need to be updated
+	LED_chipUpdate |= Pixel_bufferChanges();
+
 	// Update frame start time
 	LED_timePrev = Time_now();
 
-	// Set the page of all the ISSI chips
-	// This way we can easily link the buffers to send the brightnesses in the background
-	for ( uint8_t ch = 0; ch < ISSI_Chips_define; ch++ )
+	// Nothing changed, skip sending (static lighting)
+	if ( !LED_chipUpdate )
 	{
-		uint8_t bus = LED_ChannelMapping[ ch ].bus;
-		// Page Setup
-		LED_setupPage(
-			bus,
-			LED_ChannelMapping[ ch ].addr,
-			ISSI_LEDPwmPage
-		);
+		Pixel_FrameState = FrameState_Update;
+		goto led_finish_scan;
+	}
+
+	// Swap page buffers, PixelMap can process the next frame while this one is sent
+	if ( Pixel_frameSwap() )
+	{
+		LED_pageSend = LED_pageSend == LED_pageBuffer ? LED_pageBufferBack : LED_pageBuffer;
 	}
 
 	// Send current set of buffers
 	// Uses interrupts to send to all the ISSI chips
 	// Pixel_FrameState will be updated when complete
-	LED_chipSend = 0; // Start with chip 0
-	LED_linkedSend();
+	LED_frameSend();
 
 led_finish_scan:
 	// Latency measurement end
@@ -1225,8 +1302,12 @@ void cliFunc_ledReset( char* args )
 	for ( uint8_t buf = 0; buf < ISSI_Chips_define; buf++ )
 	{
 		memset( (void*)LED_pageBuffer[ buf ].buffer, 0, LED_BufferLength * 2 );
+		memset( (void*)LED_pageBufferBack[ buf ].buffer, 0, LED_BufferLength * 2 );
 	}
 
+	// Buffers no longer match PixelMap state, regenerate on the next frame
+	Pixel_bufferRefresh();
+
 	// Reset LEDs
 	LED_reset();
 }
@@ -1248,6 +1329,8 @@ void cliFunc_ledFPS( char* args )
 	{
 		info_print("FPS Toggle");
 		LED_displayFPS = !LED_displayFPS;
+		LED_framesSent = 0;
+		LED_framesOverlapped = 0;
 		return;
 	}
 
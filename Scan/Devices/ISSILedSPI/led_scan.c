@@ -182,6 +182,10 @@ uint8_t LED_brightness;     // Global brightness for LEDs
 
 uint32_t LED_framerate;     // Configured led framerate, given in ms per frame
 
+// Chips with modified PWM buffers that need to be sent
+// PixelMap LED_Buffers are mapped one-to-one to ISSI chips
+uint8_t LED_chipUpdate;
+
 Time LED_timePrev; // Last frame processed
 
 
@@ -430,6 +434,9 @@ void LED_reset()
 	LED_spi_transaction.status = SPI_Transaction_Status_None;
 	Pixel_FrameState = FrameState_Update;
 
+	// Chips have been reset, send every buffer on the next frame
+	LED_chipUpdate = (1 << ISSI_Chips_define) - 1;
+
 	// Un-pause ISSI processing
 	LED_pause = 0;
 }
@@ -669,9 +676,23 @@ inline void LED_scan()
 	// Update frame start time
 	LED_timePrev = Time_now();
 
+	// Nothing changed, skip sending (static lighting)
+	LED_chipUpdate |= Pixel_bufferChanges();
+	if ( !LED_chipUpdate )
+	{
+		Pixel_FrameState = FrameState_Update;
+		goto led_finish_scan;
+	}
+
 	// Do a sparse copy from the LED Buffer to the SPI Buffer
+	// Only modified chips need to be copied, the SPI buffer retains the rest
 	for (uint8_t cs = 0; cs < ISSI_Chips_define; cs++)
 	{
+		if ( !( LED_chipUpdate & (1 << cs) ) )
+		{
+			continue;
+		}
+
 		// Setup command byte
 		// Register byte is already setup (always 0x01)
 		volatile SPI_Packet *cmd = &LED_spi_buffer[cs * (LED_BufferLength + 2)];
@@ -691,6 +712,7 @@ inline void LED_scan()
 	// Purposefully not waiting, this will send in the background without interrupts or CPU interference
 	// An interrupt is only used to move onto the next transaction if any are queued
 	spi_add_transaction(&LED_spi_transaction);
+	LED_chipUpdate = 0;
 
 
 led_finish_scan:
@@ -885,6 +907,9 @@ void cliFunc_ledReset( char* args )
 		memset( (void*)LED_pageBuffer[ buf ].buffer, 0, LED_BufferLength * 2 );
 	}
 
+	// Buffers no longer match PixelMap state, regenerate on the next frame
+	Pixel_bufferRefresh();
+
 	// Reset LEDs
 	LED_reset();
 }
@@ -0,0 +1,318 @@
+/* Copyright (C) 2014-2021 by Jacob Alexander
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// ----- Includes -----
+
+// Local Includes
+#include "debounce.h"
+
+
+
+// ----- Functions -----
+
+// Reset key to the 'off' steady state
+void Debounce_keySetup( volatile KeyState *state )
+{
+	state->prevState        = KeyState_Off;
+	state->curState         = KeyState_Off;
+	state->activeCount      = 0;
+	state->inactiveCount    = DebounceDivThreshold; // Start at 'off' steady state
+	state->prevDecisionTime = 0;
+}
+
+
+// Update the debounce state of a single key
+// signal      - 1 if the sense line detected the key, 0 otherwise
+// currentTime - ms timestamp of the scan
+// expiryTime  - Minimum ms between state decisions
+DebounceResult Debounce_key( volatile KeyState *state, uint8_t signal, uint32_t currentTime, uint8_t expiryTime )
+{
+	// Signal Detected
+	// Increment count and right shift opposing count
+	// This means there is a maximum of scan 13 cycles on a perfect off to on transition
+	//  (coming from a steady state 0xFFFF off scans)
+	// Somewhat longer with switch bounciness
+	// The advantage of this is that the count is ongoing and never needs to be reset
+	// State still needs to be kept track of to deal with what to send to the Macro module
+	if ( signal )
+	{
+		// Only update if not going to wrap around
+		if ( state->activeCount < DebounceDivThreshold ) state->activeCount += 1;
+		state->inactiveCount >>= 1;
+	}
+	// Signal Not Detected
+	else
+	{
+		// Only update if not going to wrap around
+		if ( state->inactiveCount < DebounceDivThreshold ) state->inactiveCount += 1;
+		state->activeCount >>= 1;
+	}
+
+	// Check for state change
+	// But only if:
+	// 1) Enough time has passed since last state change
+	// 2) Either active or inactive count is over the debounce threshold
+
+	// Update previous state
+	state->prevState = state->curState;
+
+	// Determine time since last decision
+	uint32_t lastTransition = currentTime - state->prevDecisionTime;
+
+	// Attempt state transition
+	switch ( state->prevState )
+	{
+	case KeyState_Press:
+	case KeyState_Hold:
+		if ( state->activeCount > state->inactiveCount )
+		{
+			state->curState = KeyState_Hold;
+		}
+		else
+		{
+			// If not enough time has passed since Hold
+			// Keep previous state
+			if ( lastTransition < expiryTime )
+			{
+				state->curState = state->prevState;
+				return DebounceResult_Deferred;
+			}
+
+			state->curState = KeyState_Release;
+		}
+		break;
+
+	case KeyState_Release:
+	case KeyState_Off:
+		if ( state->activeCount > state->inactiveCount )
+		{
+			// If not enough time has passed since Hold
+			// Keep previous state
+			if ( lastTransition < expiryTime )
+			{
+				state->curState = state->prevState;
+				return DebounceResult_Deferred;
+			}
+
+			state->curState = KeyState_Press;
+		}
+		else
+		{
+			state->curState = KeyState_Off;
+		}
+		break;
+
+	case KeyState_Invalid:
+	default:
+		// Update decision time
+		state->prevDecisionTime = currentTime;
+		return DebounceResult_Invalid;
+	}
+
+	// Update decision time
+	state->prevDecisionTime = currentTime;
+
+	return DebounceResult_Decided;
+}
+
+
+// Determine if a key is in a steady Off state
+// Evaluating a steady Off key with no signal does not change any of its state (other than the decision time)
+static uint8_t Debounce_keyIdle( volatile KeyState *state )
+{
+	return state->curState == KeyState_Off
+		&& state->prevState == KeyState_Off
+		&& state->activeCount == 0
+		&& state->inactiveCount == DebounceDivThreshold;
+}
+
+
+// Reset strobe event tracking
+void Debounce_strobeSetup( DebounceStrobe *strobe )
+{
+	strobe->idle     = 0;
+	strobe->scanTime = 0;
+}
+
+
+// Time of the last state decision for the given sense line of a strobe
+// Skipped (idle) keys would have made a decision on every scan of the strobe
+uint32_t Debounce_lastDecision( DebounceStrobe *strobe, volatile KeyState *state, uint8_t sense )
+{
+	if ( strobe->idle & ( (DebounceSenseWord)1 << sense ) )
+	{
+		return strobe->scanTime;
+	}
+
+	return state->prevDecisionTime;
+}
+
+
+// Debounce a single strobe
+// keys      - KeyState of the first sense line of the strobe
+// stride    - Distance between KeyStates of each sense line (number of strobes)
+// senseMask - Sense lines to evaluate (unused/out of range keys are skipped)
+// senseWord - Bit per sense line, set if the signal was detected
+//
+// If eventDriven is set, keys in a steady Off state that are still not detected are skipped entirely.
+// A skipped key is indistinguishable from an evaluated one, as evaluating it would only update the decision time.
+// Once detected again, a steady Off key needs several more scans before the decision time is used,
+// and each of those scans makes an Off decision (updating the decision time).
+//
+// Returns the sense lines that were evaluated (and should be sent to the macro module)
+// decided is set to the sense lines which had a state decision (not deferred)
+DebounceSenseWord Debounce_strobe(
+	DebounceStrobe *strobe,
+	volatile KeyState *keys,
+	uint8_t stride,
+	DebounceSenseWord senseMask,
+	DebounceSenseWord senseWord,
+	uint32_t currentTime,
+	uint8_t expiryTime,
+	uint8_t eventDriven,
+	DebounceSenseWord *decided
+)
+{
+	DebounceSenseWord pending = senseMask;
+	*decided = 0;
+
+	// Compare against the idle keys of the previous scan, only waking keys that were detected
+	if ( eventDriven )
+	{
+		pending &= senseWord | ~strobe->idle;
+	}
+	DebounceSenseWord evaluated = pending;
+
+	// Evaluate each pending sense line
+	while ( pending )
+	{
+		uint8_t sense = __builtin_ctz( pending ); // ctz = count trailing zeros
+		DebounceSenseWord bit = (DebounceSenseWord)1 << sense;
+		pending &= ~bit;
+
+		volatile KeyState *state = &keys[ sense * stride ];
+
+		if ( Debounce_key( state, senseWord & bit ? 1 : 0, currentTime, expiryTime ) != DebounceResult_Deferred )
+		{
+			*decided |= bit;
+		}
+
+		// Update idle tracking
+		if ( Debounce_keyIdle( state ) )
+		{
+			strobe->idle |= bit;
+		}
+		else
+		{
+			strobe->idle &= ~bit;
+		}
+	}
+
+	strobe->scanTime = currentTime;
+
+	return evaluated;
+}
+
+
+
+// Reset bit-sliced strobe to the 'off' steady state
+void Debounce_bitStrobeSetup( DebounceBitStrobe *strobe )
+{
+	strobe->state = 0;
+	for ( uint8_t plane = 0; plane < DebounceBitPlanes; plane++ )
+	{
+		strobe->count[ plane ] = 0;
+	}
+	strobe->sampleTime = 0;
+}
+
+
+// Read back the vertical counter of a single sense line
+uint8_t Debounce_bitCount( DebounceBitStrobe *strobe, uint8_t sense )
+{
+	uint8_t count = 0;
+	for ( uint8_t plane = 0; plane < DebounceBitPlanes; plane++ )
+	{
+		count |= ( ( strobe->count[ plane ] >> sense ) & 1 ) << plane;
+	}
+	return count;
+}
+
+
+// Debounce a whole strobe using a bit-sliced integrator
+// senseWord  - Bit per sense line, set if the signal was detected
+// expiryTime - ms a sense line must consistently disagree with the debounced state before it changes
+//              Clamped to DebounceBitMaxTime, 0 disables debouncing
+//
+// Each sense line has a vertical counter (one bit per plane) which counts the number of ms ticks
+// the sense line has consistently disagreed with its debounced state.
+// Any agreeing sample resets the counter, so a change requires expiryTime ms without a single bounce,
+// which is the same as an expiryTime sample shift-register integrator sampled at 1 ms.
+//
+// Returns the sense lines whose debounced state changed
+DebounceSenseWord Debounce_bitStrobe(
+	DebounceBitStrobe *strobe,
+	DebounceSenseWord senseWord,
+	uint32_t currentTime,
+	uint8_t expiryTime
+)
+{
+	// Sense lines that disagree with the debounced state
+	DebounceSenseWord delta = senseWord ^ strobe->state;
+
+	// Debounce disabled
+	if ( expiryTime == 0 )
+	{
+		strobe->state = senseWord;
+		return delta;
+	}
+	if ( expiryTime > DebounceBitMaxTime )
+	{
+		expiryTime = DebounceBitMaxTime;
+	}
+
+	// Only count once per ms tick, though agreeing samples always reset the counter
+	DebounceSenseWord carry = strobe->sampleTime != currentTime ? delta : 0;
+	strobe->sampleTime = currentTime;
+
+	// Ripple-carry increment across the bit planes, clearing counters that agree
+	// Compare each plane against the expiry time at the same time
+	DebounceSenseWord expired = delta;
+	for ( uint8_t plane = 0; plane < DebounceBitPlanes; plane++ )
+	{
+		DebounceSenseWord count = strobe->count[ plane ];
+		DebounceSenseWord next = ( count ^ carry ) & delta;
+		carry &= count;
+		strobe->count[ plane ] = next;
+
+		// Every bit of the counter must match the expiry time
+		expired &= expiryTime & ( 1 << plane ) ? next : ~next;
+	}
+
+	// Toggle expired sense lines and reset their counters
+	strobe->state ^= expired;
+	for ( uint8_t plane = 0; plane < DebounceBitPlanes; plane++ )
+	{
+		strobe->count[ plane ] &= ~expired;
+	}
+
+	return expired;
+}
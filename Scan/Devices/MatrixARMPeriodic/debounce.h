@@ -0,0 +1,121 @@
+/* Copyright (C) 2014-2021 by Jacob Alexander
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+// ----- Includes -----
+
+// Compiler Includes
+#include <stdint.h>
+
+
+
+// ----- Defines -----
+
+#define DebounceCounter uint8_t
+#define DebounceDivThreshold 0xFF
+
+// A single strobe is read into a single word, one bit per sense line
+#define DebounceSenseWord uint32_t
+#define DebounceSenseMax  32
+
+// Number of bit planes used by the bit-sliced vertical counter
+// Limits the bit-sliced debounce time to 2^DebounceBitPlanes - 1 ms
+#define DebounceBitPlanes 4
+#define DebounceBitMaxTime ( ( 1 << DebounceBitPlanes ) - 1 )
+
+
+
+// ----- Enums -----
+
+// Keypress States
+typedef enum KeyPosition {
+	KeyState_Off     = 0,
+	KeyState_Press   = 1,
+	KeyState_Hold    = 2,
+	KeyState_Release = 3,
+	KeyState_Invalid,
+} KeyPosition;
+
+// Debounce decision results
+typedef enum DebounceResult {
+	DebounceResult_Decided  = 0, // State decision was made (may be the same state)
+	DebounceResult_Deferred = 1, // Decision held back until the debounce time expires
+	DebounceResult_Invalid  = 2, // Key was in an invalid state
+} DebounceResult;
+
+
+
+// ----- Structs -----
+
+// Debounce Element
+typedef struct KeyState {
+	DebounceCounter activeCount;
+	DebounceCounter inactiveCount;
+	KeyPosition     prevState;
+	KeyPosition     curState;
+	uint32_t        prevDecisionTime;
+} KeyState;
+
+// Per-strobe state used for event-driven scanning
+typedef struct DebounceStrobe {
+	DebounceSenseWord idle;     // Sense lines with keys in a steady Off state (not re-evaluated)
+	uint32_t          scanTime; // Time of the previous scan of this strobe
+} DebounceStrobe;
+
+// Bit-sliced debounce state of a single strobe
+// Each word holds a bit per sense line, the counter is stored vertically across the bit planes
+typedef struct DebounceBitStrobe {
+	DebounceSenseWord state;                        // Debounced state (1 - pressed)
+	DebounceSenseWord count[ DebounceBitPlanes ];   // ms the sense line has consistently disagreed with state
+	uint32_t          sampleTime;                   // Time of the last counter increment
+} DebounceBitStrobe;
+
+
+
+// ----- Functions -----
+
+void Debounce_keySetup( volatile KeyState *state );
+DebounceResult Debounce_key( volatile KeyState *state, uint8_t signal, uint32_t currentTime, uint8_t expiryTime );
+
+void Debounce_strobeSetup( DebounceStrobe *strobe );
+uint32_t Debounce_lastDecision( DebounceStrobe *strobe, volatile KeyState *state, uint8_t sense );
+DebounceSenseWord Debounce_strobe(
+	DebounceStrobe *strobe,
+	volatile KeyState *keys,
+	uint8_t stride,
+	DebounceSenseWord senseMask,
+	DebounceSenseWord senseWord,
+	uint32_t currentTime,
+	uint8_t expiryTime,
+	uint8_t eventDriven,
+	DebounceSenseWord *decided
+);
+
+void Debounce_bitStrobeSetup( DebounceBitStrobe *strobe );
+uint8_t Debounce_bitCount( DebounceBitStrobe *strobe, uint8_t sense );
+DebounceSenseWord Debounce_bitStrobe(
+	DebounceBitStrobe *strobe,
+	DebounceSenseWord senseWord,
+	uint32_t currentTime,
+	uint8_t expiryTime
+);
+
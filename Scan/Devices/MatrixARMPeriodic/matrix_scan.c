@@ -63,7 +63,7 @@ const GPIO_Pin Matrix_rows[] = { ScanCodeSenseList_define };
 // Convenience Macros
 #define Matrix_colsNum sizeof( Matrix_cols ) / sizeof( GPIO_Pin )
 #define Matrix_rowsNum sizeof( Matrix_rows ) / sizeof( GPIO_Pin )
-#define Matrix_maxKeys sizeof( Matrix_scanArray ) / sizeof( KeyState )
+#define Matrix_maxKeys ( Matrix_colsNum * Matrix_rowsNum )
 
 
 
@@ -96,9 +96,22 @@ CLIDict_Def( matrixCLIDict, "Matrix Module Commands" ) = {
 	{ 0, 0, 0 } // Null entry for dictionary end
 };
 
+#if MatrixDebounceEngine_define == 1
+// Bit-sliced Debounce Array
+static DebounceBitStrobe Matrix_bitStrobeState[ Matrix_colsNum ];
+#else
 // Debounce Array
 static volatile KeyState Matrix_scanArray[ Matrix_colsNum * Matrix_rowsNum ];
 
+// Per-strobe debounce tracking
+static DebounceStrobe Matrix_strobeState[ Matrix_colsNum ];
+#endif
+
+// Per-strobe mask of sense lines that map to a valid ScanCode
+static DebounceSenseWord Matrix_senseMask[ Matrix_colsNum ];
+
+_Static_assert( Matrix_rowsNum <= DebounceSenseMax, "Too many sense lines for a single DebounceSenseWord" );
+
 
 #if ScanCodeRemapping_define == 1
 // ScanCode Remapping Array
@@ -145,6 +158,17 @@ static volatile uint16_t matrixStateReleaseCount;
 
 // ----- Functions -----
 
+// Convert matrix position to ScanCode
+static uint16_t Matrix_keyDisplay( uint16_t key )
+{
+#if ScanCodeRemapping_define == 1
+	return matrixScanCodeRemappingMatrix[key];
+#else
+	return key + 1; // 1-indexed for reporting purposes
+#endif
+}
+
+
 // Setup GPIO pins for matrix scanning
 void Matrix_setup()
 {
@@ -184,14 +208,39 @@ void Matrix_setup()
 		GPIO_Ctrl(Matrix_rows[c], GPIO_Type_ReadSetup, Matrix_type);
 	}
 
+#if MatrixDebounceEngine_define == 1
+	// Clear out Bit-sliced Debounce Array
+	for ( uint8_t strobe = 0; strobe < Matrix_colsNum; strobe++ )
+	{
+		Debounce_bitStrobeSetup( &Matrix_bitStrobeState[ strobe ] );
+	}
+#else
 	// Clear out Debounce Array
 	for ( uint8_t item = 0; item < Matrix_maxKeys; item++ )
 	{
-		Matrix_scanArray[ item ].prevState        = KeyState_Off;
-		Matrix_scanArray[ item ].curState         = KeyState_Off;
-		Matrix_scanArray[ item ].activeCount      = 0;
-		Matrix_scanArray[ item ].inactiveCount    = DebounceDivThreshold; // Start at 'off' steady state
-		Matrix_scanArray[ item ].prevDecisionTime = 0;
+		Debounce_keySetup( &Matrix_scanArray[ item ] );
+	}
+#endif
+
+	// Setup per-strobe tracking
+	for ( uint8_t strobe = 0; strobe < Matrix_colsNum; strobe++ )
+	{
+#if MatrixDebounceEngine_define == 0
+		Debounce_strobeSetup( &Matrix_strobeState[ strobe ] );
+#endif
+
+		// Check bounds, ScanCodes outside of the map are never scanned
+		// 1-indexed as ScanCode 0 is not used
+		Matrix_senseMask[ strobe ] = 0;
+		for ( uint8_t sense = 0; sense < Matrix_rowsNum; sense++ )
+		{
+			uint16_t key_disp = Matrix_keyDisplay( Matrix_colsNum * sense + strobe );
+			if ( key_disp > MaxScanCode_KLL || key_disp == 0 )
+			{
+				continue;
+			}
+			Matrix_senseMask[ strobe ] |= (DebounceSenseWord)1 << sense;
+		}
 	}
 
 	// Reset strobe position
@@ -264,143 +313,177 @@ inline uint8_t Matrix_totalColumns()
 }
 
 
-// Single strobe matrix scan
-// Only goes through a single strobe
-// This module keeps track of the next strobe to scan
-uint8_t Matrix_single_scan()
+// Activity and inactivity tracking of a key state decision
+static void Matrix_keyActivity( KeyPosition curState )
 {
-	// Start latency measurement
-	Latency_start_time( matrixLatencyResource );
+	if ( curState != KeyState_Off )
+	{
+		matrixStateActiveCount++;
+	}
+	switch ( curState )
+	{
+	case KeyState_Press:
+		matrixStatePressCount++;
+		break;
 
+	case KeyState_Release:
+		matrixStateReleaseCount++;
+		break;
 
-	// Read systick for event scheduling
-	uint32_t currentTime = systick_millis_count;
+	default:
+		break;
+	}
+}
 
-	// Current strobe
-	uint8_t strobe = matrixCurrentStrobe;
 
-	// XXX (HaaTa)
-	// Before strobing drain each sense line
-	// This helps with faulty pull-up resistors (particularily with SAM4S)
-	for ( uint8_t sense = 0; sense < Matrix_rowsNum; sense++ )
+// Matrix Debug, only if there is a state change
+static void Matrix_keyDebug( uint16_t key_disp, KeyPosition prevState, KeyPosition curState )
+{
+	if ( !matrixDebugMode || curState == prevState )
 	{
-		GPIO_Ctrl( Matrix_rows[ sense ], GPIO_Type_DriveSetup, Matrix_type );
-#if ScanCodeMatrixInvert_define == 2 // GPIO_Config_Pulldown
-		GPIO_Ctrl( Matrix_rows[ sense ], GPIO_Type_DriveLow, Matrix_type );
-#elif ScanCodeMatrixInvert_define == 1 // GPIO_Config_Pullup
-		GPIO_Ctrl( Matrix_rows[ sense ], GPIO_Type_DriveHigh, Matrix_type );
-#endif
-		GPIO_Ctrl( Matrix_rows[ sense ], GPIO_Type_ReadSetup, Matrix_type );
+		return;
 	}
 
-	// Strobe Pin
-	GPIO_Ctrl( Matrix_cols[ strobe ], GPIO_Type_DriveHigh, Matrix_type );
-
-	// Used to allow the strobe signal to propagate, generally not required
-	if ( strobeDelayTime > 0 )
+	// Basic debug output
+	if ( matrixDebugMode == 1 && curState == KeyState_Press )
 	{
-		delay_us( strobeDelayTime );
+		printInt16( key_disp );
+		print(":");
+		printHex( key_disp );
+		print(" ");
+#if enableRawIO_define == 1
+		HIDIO_print_flush();
+#endif
 	}
-
-	// Scan each of the sense pins
-	for ( uint8_t sense = 0; sense < Matrix_rowsNum; sense++ )
+	// State transition debug output
+	else if ( matrixDebugMode == 2 )
 	{
-		// Key position
-		uint16_t key = Matrix_colsNum * sense + strobe;
-#if ScanCodeRemapping_define == 1
-		uint16_t key_disp = matrixScanCodeRemappingMatrix[key];
-#else
-		uint16_t key_disp = key + 1; // 1-indexed for reporting purposes
+		printInt16( key_disp );
+		Matrix_keyPositionDebug( curState );
+		print(" ");
+#if enableRawIO_define == 1
+		HIDIO_print_flush();
 #endif
+	}
+}
 
-		// Check bounds, before attempting to scan
-		// 1-indexed as ScanCode 0 is not used
-		if ( key_disp > MaxScanCode_KLL || key_disp == 0 )
+
+#if MatrixDebounceEngine_define == 1
+// Bit-sliced debounce of a single strobe
+// Only keys that are pressed, held or released are sent to the macro module
+static void Matrix_bitSlicedScan( uint8_t strobe, DebounceSenseWord senseWord, uint32_t currentTime )
+{
+	DebounceBitStrobe *bitStrobe = &Matrix_bitStrobeState[ strobe ];
+	DebounceSenseWord prev = bitStrobe->state;
+	DebounceSenseWord changed = Debounce_bitStrobe(
+		bitStrobe,
+		senseWord & Matrix_senseMask[ strobe ],
+		currentTime,
+		debounceExpiryTime
+	);
+	DebounceSenseWord cur = bitStrobe->state;
+	DebounceSenseWord pending = prev | cur;
+
+	// Process each of the pressed, held or released keys
+	for ( uint8_t sense = 0; pending; sense++ )
+	{
+		DebounceSenseWord bit = (DebounceSenseWord)1 << sense;
+		if ( !( pending & bit ) )
 		{
 			continue;
 		}
-		volatile KeyState *state = &Matrix_scanArray[ key ];
+		pending &= ~bit;
 
-		// Signal Detected
-		// Increment count and right shift opposing count
-		// This means there is a maximum of scan 13 cycles on a perfect off to on transition
-		//  (coming from a steady state 0xFFFF off scans)
-		// Somewhat longer with switch bounciness
-		// The advantage of this is that the count is ongoing and never needs to be reset
-		// State still needs to be kept track of to deal with what to send to the Macro module
-		// Compared against the default state value (ScanCodeMatrixInvert_define), usually 0
-		if ( GPIO_Ctrl( Matrix_rows[ sense ], GPIO_Type_Read, Matrix_type ) != ScanCodeMatrixInvert_define )
+		// Determine key position from the previous and current debounced state
+		KeyPosition prevState = prev & bit ? KeyState_Hold : KeyState_Off;
+		KeyPosition curState = KeyState_Hold;
+		if ( changed & bit )
 		{
-			// Only update if not going to wrap around
-			if ( state->activeCount < DebounceDivThreshold ) state->activeCount += 1;
-			state->inactiveCount >>= 1;
+			curState = cur & bit ? KeyState_Press : KeyState_Release;
 		}
-		// Signal Not Detected
-		else
+
+		// Send keystate to macro module
+		uint16_t key_disp = Matrix_keyDisplay( Matrix_colsNum * sense + strobe );
+		Macro_keyState( key_disp, curState );
+
+		// Activity tracking and state transition debug output
+		Matrix_keyActivity( curState );
+		Matrix_keyDebug( key_disp, prevState, curState );
+
+		// Counter debug output, only if there is a state change
+		if ( matrixDebugMode == 3 && ( changed & bit ) )
 		{
-			// Only update if not going to wrap around
-			if ( state->inactiveCount < DebounceDivThreshold ) state->inactiveCount += 1;
-			state->activeCount >>= 1;
+			print("\033[1m");
+			printInt16( key_disp );
+			print("\033[0m");
+			print(":");
+			Matrix_keyPositionDebug( curState );
+			print(" 0x");
+			printHex_op( Debounce_bitCount( bitStrobe, sense ), 2 );
+			print( NL );
+		}
+	}
+}
+
+#else
+// Per-key debounce of a single strobe
+static void Matrix_keyStateScan( uint8_t strobe, DebounceSenseWord senseWord, uint32_t currentTime )
+{
+	// Keep track of the previous decision times for state transition debug output
+	uint32_t prevDecisionTime[ Matrix_rowsNum ];
+	if ( matrixDebugMode == 3 )
+	{
+		for ( uint8_t sense = 0; sense < Matrix_rowsNum; sense++ )
+		{
+			prevDecisionTime[ sense ] = Debounce_lastDecision(
+				&Matrix_strobeState[ strobe ],
+				&Matrix_scanArray[ Matrix_colsNum * sense + strobe ],
+				sense
+			);
 		}
+	}
 
-		// Check for state change
-		// But only if:
-		// 1) Enough time has passed since last state change
-		// 2) Either active or inactive count is over the debounce threshold
+	// Debounce the strobe
+	// In event-driven mode, only keys that are detected or not in a steady Off state are evaluated
+	DebounceSenseWord decided;
+	DebounceSenseWord evaluated = Debounce_strobe(
+		&Matrix_strobeState[ strobe ],
+		&Matrix_scanArray[ strobe ],
+		Matrix_colsNum,
+		Matrix_senseMask[ strobe ],
+		senseWord,
+		currentTime,
+		debounceExpiryTime,
+		MatrixScanEventDriven_define,
+		&decided
+	);
+
+	// Process each of the evaluated keys
+	for ( uint8_t sense = 0; sense < Matrix_rowsNum; sense++ )
+	{
+		DebounceSenseWord bit = (DebounceSenseWord)1 << sense;
+		if ( !( evaluated & bit ) )
+		{
+			continue;
+		}
 
-		// Update previous state
-		state->prevState = state->curState;
+		// Key position
+		uint16_t key = Matrix_colsNum * sense + strobe;
+		uint16_t key_disp = Matrix_keyDisplay( key );
+		volatile KeyState *state = &Matrix_scanArray[ key ];
 
-		// Determine time since last decision
-		uint32_t lastTransition = currentTime - state->prevDecisionTime;
+		// Send keystate to macro module
+		Macro_keyState( key_disp, state->curState );
 
-		// Attempt state transition
-		switch ( state->prevState )
+		// Decision was deferred, state has not changed
+		if ( !( decided & bit ) )
 		{
-		case KeyState_Press:
-		case KeyState_Hold:
-			if ( state->activeCount > state->inactiveCount )
-			{
-				state->curState = KeyState_Hold;
-			}
-			else
-			{
-				// If not enough time has passed since Hold
-				// Keep previous state
-				if ( lastTransition < debounceExpiryTime )
-				{
-					state->curState = state->prevState;
-					Macro_keyState( key_disp, state->curState );
-					continue;
-				}
-
-				state->curState = KeyState_Release;
-			}
-			break;
-
-		case KeyState_Release:
-		case KeyState_Off:
-			if ( state->activeCount > state->inactiveCount )
-			{
-				// If not enough time has passed since Hold
-				// Keep previous state
-				if ( lastTransition < debounceExpiryTime )
-				{
-					state->curState = state->prevState;
-					Macro_keyState( key_disp, state->curState );
-					continue;
-				}
-
-				state->curState = KeyState_Press;
-			}
-			else
-			{
-				state->curState = KeyState_Off;
-			}
-			break;
+			continue;
+		}
 
-		case KeyState_Invalid:
-		default:
+		// Invalid key state, should never happen
+		if ( state->prevState >= KeyState_Invalid )
+		{
 			erro_print("Matrix scan bug!! Report me! - ");
 			printHex( state->prevState );
 			print(" Col: ");
@@ -410,78 +493,90 @@ uint8_t Matrix_single_scan()
 			print(" Key: ");
 			printHex( key_disp );
 			print( NL );
-			break;
 		}
 
-		// Update decision time
-		state->prevDecisionTime = currentTime;
-
-		// Send keystate to macro module
-		Macro_keyState( key_disp, state->curState );
+		// Activity tracking and state transition debug output
+		Matrix_keyActivity( state->curState );
+		Matrix_keyDebug( key_disp, state->prevState, state->curState );
 
-		// Check for activity and inactivity
-		if ( state->curState != KeyState_Off )
+		// Counter debug output, only if there is a state change
+		if ( matrixDebugMode == 3 && state->curState != state->prevState )
 		{
-			matrixStateActiveCount++;
+			print("\033[1m");
+			printInt16( key_disp );
+			print("\033[0m");
+			print(":");
+			Matrix_keyPositionDebug( Matrix_scanArray[ key ].prevState );
+			Matrix_keyPositionDebug( Matrix_scanArray[ key ].curState );
+			print(" 0x");
+			printHex_op( state->activeCount, 2 );
+			print(" 0x");
+			printHex_op( state->inactiveCount, 2 );
+			print(" ");
+			printInt32( currentTime - prevDecisionTime[ sense ] );
+			print( NL );
 		}
-		switch ( state->curState )
-		{
-		case KeyState_Press:
-			matrixStatePressCount++;
-			break;
+	}
+}
+#endif
 
-		case KeyState_Release:
-			matrixStateReleaseCount++;
-			break;
 
-		default:
-			break;
-		}
+// Single strobe matrix scan
+// Only goes through a single strobe
+// This module keeps track of the next strobe to scan
+uint8_t Matrix_single_scan()
+{
+	// Start latency measurement
+	Latency_start_time( matrixLatencyResource );
 
-		// Matrix Debug, only if there is a state change
-		if ( matrixDebugMode && state->curState != state->prevState )
-		{
-			// Basic debug output
-			if ( matrixDebugMode == 1 && state->curState == KeyState_Press )
-			{
-				printInt16( key_disp );
-				print(":");
-				printHex( key_disp );
-				print(" ");
-#if enableRawIO_define == 1
-				HIDIO_print_flush();
-#endif
-			}
-			// State transition debug output
-			else if ( matrixDebugMode == 2 )
-			{
-				printInt16( key_disp );
-				Matrix_keyPositionDebug( state->curState );
-				print(" ");
-#if enableRawIO_define == 1
-				HIDIO_print_flush();
+
+	// Read systick for event scheduling
+	uint32_t currentTime = systick_millis_count;
+
+	// Current strobe
+	uint8_t strobe = matrixCurrentStrobe;
+
+	// XXX (HaaTa)
+	// Before strobing drain each sense line
+	// This helps with faulty pull-up resistors (particularily with SAM4S)
+	for ( uint8_t sense = 0; sense < Matrix_rowsNum; sense++ )
+	{
+		GPIO_Ctrl( Matrix_rows[ sense ], GPIO_Type_DriveSetup, Matrix_type );
+#if ScanCodeMatrixInvert_define == 2 // GPIO_Config_Pulldown
+		GPIO_Ctrl( Matrix_rows[ sense ], GPIO_Type_DriveLow, Matrix_type );
+#elif ScanCodeMatrixInvert_define == 1 // GPIO_Config_Pullup
+		GPIO_Ctrl( Matrix_rows[ sense ], GPIO_Type_DriveHigh, Matrix_type );
 #endif
-			}
-			else if ( matrixDebugMode == 3 )
-			{
-				print("\033[1m");
-				printInt16( key_disp );
-				print("\033[0m");
-				print(":");
-				Matrix_keyPositionDebug( Matrix_scanArray[ key ].prevState );
-				Matrix_keyPositionDebug( Matrix_scanArray[ key ].curState );
-				print(" 0x");
-				printHex_op( state->activeCount, 2 );
-				print(" 0x");
-				printHex_op( state->inactiveCount, 2 );
-				print(" ");
-				printInt32( lastTransition );
-				print( NL );
-			}
+		GPIO_Ctrl( Matrix_rows[ sense ], GPIO_Type_ReadSetup, Matrix_type );
+	}
 
+	// Strobe Pin
+	GPIO_Ctrl( Matrix_cols[ strobe ], GPIO_Type_DriveHigh, Matrix_type );
+
+	// Used to allow the strobe signal to propagate, generally not required
+	if ( strobeDelayTime > 0 )
+	{
+		delay_us( strobeDelayTime );
+	}
+
+	// Read each of the sense pins into a single word
+	// Compared against the default state value (ScanCodeMatrixInvert_define), usually 0
+	DebounceSenseWord senseWord = 0;
+	for ( uint8_t sense = 0; sense < Matrix_rowsNum; sense++ )
+	{
+		if ( GPIO_Ctrl( Matrix_rows[ sense ], GPIO_Type_Read, Matrix_type ) != ScanCodeMatrixInvert_define )
+		{
+			senseWord |= (DebounceSenseWord)1 << sense;
 		}
 	}
 
+	// Debounce the strobe and send key states to the macro module
+#if MatrixDebounceEngine_define == 1
+	Matrix_bitSlicedScan( strobe, senseWord, currentTime );
+#else
+	Matrix_keyStateScan( strobe, senseWord, currentTime );
+#endif
+
 	// Unstrobe Pin
 	GPIO_Ctrl( Matrix_cols[ strobe ], GPIO_Type_DriveLow, Matrix_type );
 
@@ -496,7 +591,11 @@ uint8_t Matrix_single_scan()
 		matrixDebugStateCounter--;
 
 		// Display the state info for each key
+#if MatrixDebounceEngine_define == 1
+		print("<key>:<debounced state> <ms count>");
+#else
 		print("<key>:<previous state><current state> <active count> <inactive count>");
+#endif
 		for ( uint8_t key = 0; key < Matrix_maxKeys; key++ )
 		{
 			// Every 4 keys, put a newline
@@ -507,12 +606,20 @@ uint8_t Matrix_single_scan()
 			printInt16( key + 1 );
 			print("\033[0m");
 			print(":");
+#if MatrixDebounceEngine_define == 1
+			DebounceBitStrobe *bitStrobe = &Matrix_bitStrobeState[ key % Matrix_colsNum ];
+			uint8_t sense = key / Matrix_colsNum;
+			Matrix_keyPositionDebug( bitStrobe->state & ( (DebounceSenseWord)1 << sense ) ? KeyState_Hold : KeyState_Off );
+			print(" 0x");
+			printHex_op( Debounce_bitCount( bitStrobe, sense ), 2 );
+#else
 			Matrix_keyPositionDebug( Matrix_scanArray[ key ].prevState );
 			Matrix_keyPositionDebug( Matrix_scanArray[ key ].curState );
 			print(" 0x");
 			printHex_op( Matrix_scanArray[ key ].activeCount, 2 );
 			print(" 0x");
 			printHex_op( Matrix_scanArray[ key ].inactiveCount, 2 );
+#endif
 			print(" ");
 		}
 
@@ -624,6 +731,19 @@ void cliFunc_matrixInfo( char* args )
 	print( NL );
 	info_print("Max Keys: ");
 	printInt8( Matrix_maxKeys );
+
+	print( NL );
+	info_print("Debounce Engine: ");
+#if MatrixDebounceEngine_define == 1
+	print("Bit-sliced (max ");
+	printInt8( DebounceBitMaxTime );
+	print("ms)");
+#else
+	print("Per-key");
+	print( NL );
+	info_print("Event Driven: ");
+	printInt8( MatrixScanEventDriven_define );
+#endif
 }
 
 void cliFunc_matrixDebug( char* args )
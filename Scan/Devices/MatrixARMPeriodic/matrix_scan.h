@@ -29,12 +29,12 @@
 // KLL Generated Defines
 #include <kll_defs.h>
 
+// Local Includes
+#include "debounce.h"
 
 
-// ----- Defines -----
 
-#define DebounceCounter uint8_t
-#define DebounceDivThreshold 0xFF
+// ----- Defines -----
 
 #if   ( MinDebounceTime_define > 0xFF )
 #error "MinDebounceTime is a maximum of 255 ms"
@@ -42,31 +42,9 @@
 #error "MinDebounceTime is a minimum 0 ms"
 #endif
 
-
-
-// ----- Enums -----
-
-// Keypress States
-typedef enum KeyPosition {
-	KeyState_Off     = 0,
-	KeyState_Press   = 1,
-	KeyState_Hold    = 2,
-	KeyState_Release = 3,
-	KeyState_Invalid,
-} KeyPosition;
-
-
-
-// ----- Structs -----
-
-// Debounce Element
-typedef struct KeyState {
-	DebounceCounter activeCount;
-	DebounceCounter inactiveCount;
-	KeyPosition     prevState;
-	KeyPosition     curState;
-	uint32_t        prevDecisionTime;
-} KeyState;
+#if MatrixDebounceEngine_define == 1 && MinDebounceTime_define > DebounceBitMaxTime
+#error "MinDebounceTime is too long for the bit-sliced debounce engine (see DebounceBitPlanes)"
+#endif
 
 
 
@@ -19,6 +19,10 @@
 // Compiler Includes
 #include <Lib/ScanLib.h>
 
+#if defined(_kinetis_)
+#include <Lib/atomic.h>
+#endif
+
 // Project Includes
 #include <cli.h>
 #include <kll_defs.h>
@@ -56,22 +60,22 @@
 		print("/"); \
 		printHex( UART##uartNum##_TCFIFO ); \
 		print("/"); \
-		printHex( uart_tx_buf[ uartNum ].items ); \
+		printHex( Connect_txItems( uartNum ) ); \
 		print( NL ); \
 	} \
 	/* XXX Doesn't work well */ \
 	/* while ( UART##uartNum##_TCFIFO < fifoSize ) */ \
 	/* More reliable, albeit slower */ \
 	fifoSize -= UART##uartNum##_TCFIFO; \
-	while ( fifoSize-- != 0 ) \
+	uint16_t head = uart_tx_buf[ uartNum ].head; \
+	uint16_t tail = __atomic_load_n( &uart_tx_buf[ uartNum ].tail, __ATOMIC_ACQUIRE ); \
+	while ( fifoSize-- != 0 && head != tail ) \
 	{ \
-		if ( uart_tx_buf[ uartNum ].items == 0 ) \
-			break; \
-		UART##uartNum##_D = uart_tx_buf[ uartNum ].buffer[ uart_tx_buf[ uartNum ].head++ ]; \
-		uart_tx_buf[ uartNum ].items--; \
-		if ( uart_tx_buf[ uartNum ].head >= UART_Buffer_Size ) \
-			uart_tx_buf[ uartNum ].head = 0; \
+		UART##uartNum##_D = uart_tx_buf[ uartNum ].buffer[ head++ ]; \
+		if ( head >= UART_Buffer_Size ) \
+			head = 0; \
 	} \
+	__atomic_store_n( &uart_tx_buf[ uartNum ].head, head, __ATOMIC_RELEASE ); \
 }
 
 // Macros for locking/unlock Tx buffers
@@ -99,10 +103,14 @@
 
 #define uart_unlockTx( uartNum ) \
 { \
+	/* Queue the frame */ \
+	Connect_txFrame( uartNum ); \
 	/* Ready the UART */ \
 	uart_tx_status[ uartNum ].status = UARTStatus_Ready; \
 	/* Unlock the resource */ \
 	uart_tx_status[ uartNum ].lock = 0; \
+	/* Start sending the message */ \
+	Connect_txKick( uartNum ); \
 }
 
 
@@ -118,14 +126,20 @@ void cliFunc_connectMst ( char *args );
 void cliFunc_connectRst ( char *args );
 void cliFunc_connectSts ( char *args );
 
+// Tx Functions
+uint16_t Connect_txItems( uint8_t uart );
+void Connect_txFrame( uint8_t uart );
+void Connect_txKick( uint8_t uart );
+
 
 
 // ----- Structs -----
 
+// Single producer (Connect_addBytes), single consumer (Tx FIFO fill) ring buffer
+// One byte is always left empty to tell a full buffer from an empty one
 typedef struct UARTRingBuf {
-	uint8_t head;
-	uint8_t tail;
-	uint8_t items;
+	uint16_t head; // Written by consumer
+	uint16_t tail; // Written by producer
 	uint8_t buffer[UART_Buffer_Size];
 } UARTRingBuf;
 
@@ -134,15 +148,26 @@ typedef struct UARTDMABuf {
 	uint16_t last_read;
 } UARTDMABuf;
 
+// Rx frame buffer holds Length, Command, Data and CRC
+// After a failed frame the bytes following the next SYN are replayed from the same buffer
+// (frame bytes are always written behind the replay position)
 typedef struct UARTStatusRx {
 	UARTStatus status;
 	Command    command;
 	uint16_t   bytes_waiting;
+	uint8_t    crc;
+	uint16_t   frame_pos;
+	uint16_t   replay_pos;
+	uint16_t   replay_len;
+	uint8_t    frame[UART_Buffer_Size];
 } UARTStatusRx;
 
+// Tx frame buffer holds the command queued between uart_lockTx and uart_unlockTx
 typedef struct UARTStatusTx {
 	UARTStatus status;
 	uint8_t    lock;
+	uint16_t   frame_len;
+	uint8_t    frame[UART_Buffer_Size];
 } UARTStatusTx;
 
 
@@ -183,6 +208,7 @@ uint8_t Connect_maxId = 0;
 uint32_t Connect_lastCheck = 0; // Cable Check scheduler
 uint8_t Connect_debug = 0;      // Set 1 for debug
 uint8_t Connect_override = 0;   // Prevents master from automatically being set
+uint8_t Connect_compact = 0;    // Set by the master, send ScanCodes using ScanCodeCompact
 
 volatile uint8_t uarts_configured = 0;
 
@@ -198,55 +224,185 @@ volatile UARTStatusRx uart_rx_status[UART_Num_Interfaces];
 UARTRingBuf  uart_tx_buf   [UART_Num_Interfaces];
 UARTStatusTx uart_tx_status[UART_Num_Interfaces];
 
+uint32_t Connect_txDropped[UART_Num_Interfaces]; // Bytes dropped due to a full Tx buffer
+
+
+// -- Frame Variables --
+
+uint32_t Connect_rxFrames[UART_Num_Interfaces];        // Verified frames
+uint32_t Connect_rxCrcErrors[UART_Num_Interfaces];     // Frames dropped due to a CRC mismatch
+uint32_t Connect_rxFramingErrors[UART_Num_Interfaces]; // Frames dropped due to an invalid length
+
+// CRC-8 (poly 0x07), 4 bits at a time
+static const uint8_t Connect_crc8Table[] = {
+	0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+	0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
+};
+
+static inline uint8_t Connect_crc8( uint8_t crc, uint8_t byte )
+{
+	crc ^= byte;
+	crc = ( crc << 4 ) ^ Connect_crc8Table[ crc >> 4 ];
+	crc = ( crc << 4 ) ^ Connect_crc8Table[ crc >> 4 ];
+	return crc;
+}
+
+uint32_t Connect_scanCodeTxEvents = 0; // ScanCode events sent to master
+uint32_t Connect_scanCodeTxBytes  = 0; // Bytes used to send them (including headers)
+uint32_t Connect_scanCodeTxDropped = 0; // ScanCode events dropped while the master bound Tx was backed up
+
 
 // -- Ring Buffer Convenience Functions --
 
-void Connect_addBytes( uint8_t *buffer, uint8_t count, uint8_t uart )
+// Number of bytes waiting to be sent
+uint16_t Connect_txItems( uint8_t uart )
 {
-	// Too big to fit into buffer
-	if ( count > UART_Buffer_Size )
-	{
-		erro_print("Too big of a command to fit into the buffer...");
+	uint16_t head = __atomic_load_n( &uart_tx_buf[ uart ].head, __ATOMIC_ACQUIRE );
+	uint16_t tail = __atomic_load_n( &uart_tx_buf[ uart ].tail, __ATOMIC_ACQUIRE );
+	return tail >= head ? tail - head : UART_Buffer_Size - head + tail;
+}
+
+// Check if there is room to queue a message of count bytes (plus framing)
+// Used to reserve space for a whole message, before it's queued in parts
+uint8_t Connect_txReady( uint8_t uart, uint16_t count )
+{
+	return Connect_txItems( uart ) + count + FRAME_OVERHEAD < UART_Buffer_Size;
+}
+
+// Fill the Tx FIFO from the ring buffer
+// Called once a message has been queued, the rest is drained by Connect_scan
+// Messages may be queued outside of the periodic thread, so the FIFO fill (consumer) is kept atomic
+void Connect_txKick( uint8_t uart )
+{
+	if ( !uarts_configured )
 		return;
+
+#if defined(_kinetis_)
+	ATOMIC_BLOCK( ATOMIC_RESTORESTATE )
+	{
+		switch ( uart )
+		{
+		case 0:
+			uart_fillTxFifo( 0 );
+			break;
+		case 1:
+			uart_fillTxFifo( 1 );
+			break;
+		}
+	}
+#elif defined(_sam_)
+	//SAM TODO
+#endif
+}
+
+// Append bytes to the Tx ring buffer
+// Room must be checked by the caller
+static void Connect_txPush( uint8_t *buffer, uint16_t count, uint8_t uart )
+{
+	// Append data to ring buffer, splitting the copy at the end of the buffer
+	UARTRingBuf *buf = &uart_tx_buf[ uart ];
+	uint16_t tail = buf->tail;
+	uint16_t cur_len = UART_Buffer_Size - tail;
+	if ( count < cur_len )
+	{
+		memcpy( &buf->buffer[ tail ], buffer, count );
+		tail += count;
+	}
+	else
+	{
+		memcpy( &buf->buffer[ tail ], buffer, cur_len );
+		memcpy( buf->buffer, &buffer[ cur_len ], count - cur_len );
+		tail = count - cur_len;
 	}
 
+	// Hand data over to the consumer
+	__atomic_store_n( &buf->tail, tail, __ATOMIC_RELEASE );
+}
+
+// Append bytes to the Tx frame of a locked UART
+// The frame is queued by uart_unlockTx
+// Does not block, if there isn't enough room nothing is queued and 0 is returned
+uint8_t Connect_addBytes( uint8_t *buffer, uint8_t count, uint8_t uart )
+{
 	// Invalid UART
 	if ( uart >= UART_Num_Interfaces )
 	{
 		erro_printNL("Invalid UART to send from...");
-		return;
+		return 0;
 	}
 
-	// Delay UART copy until there's some space left
-	while ( uart_tx_buf[ uart ].items + count > UART_Buffer_Size )
+	// Too big to fit into frame
+	UARTStatusTx *status = &uart_tx_status[ uart ];
+	if ( status->frame_len + count > UART_Buffer_Size )
 	{
-		warn_print("Too much data to send on UART");
-		printInt8( uart );
-		print( ", waiting..." NL );
-		delay_ms( 1 );
-		// FIXME Buffer will not drain here....
+		erro_print("Too big of a command to fit into the buffer...");
+		Connect_txDropped[ uart ] += count;
+		return 0;
 	}
 
-	// Append data to ring buffer
-	for ( uint8_t c = 0; c < count; c++ )
+	if ( Connect_debug )
 	{
-		if ( Connect_debug )
+		for ( uint8_t c = 0; c < count; c++ )
 		{
 			printHex( buffer[ c ] );
 			print(" +");
 			printInt8( uart );
 			print( NL );
 		}
+	}
+
+	memcpy( &status->frame[ status->frame_len ], buffer, count );
+	status->frame_len += count;
+	return 1;
+}
+
+// Queue the Tx frame into the Tx ring buffer, adding Length and CRC-8
+// Bytes that aren't a command (e.g. Idle SYNs) are queued as-is
+// Does not block, if there isn't enough room the whole frame is dropped
+void Connect_txFrame( uint8_t uart )
+{
+	UARTStatusTx *status = &uart_tx_status[ uart ];
+	uint16_t len = status->frame_len;
+	status->frame_len = 0;
+
+	// Nothing queued
+	if ( len == 0 )
+		return;
+
+	uint8_t isCommand = len > 2 && status->frame[0] == Command_SYN && status->frame[1] == SOH;
+	uint16_t total = isCommand ? len + FRAME_OVERHEAD : len;
+
+	// Not enough room, drop frame
+	if ( Connect_txItems( uart ) + total >= UART_Buffer_Size )
+	{
+		Connect_txDropped[ uart ] += total;
+		if ( Connect_debug )
+		{
+			warn_print("Too much data to send on UART");
+			printInt8( uart );
+			print( ", dropping..." NL );
+		}
+		return;
+	}
 
-		uart_tx_buf[ uart ].buffer[ uart_tx_buf[ uart ].tail++ ] = buffer[ c ];
-		uart_tx_buf[ uart ].items++;
-		if ( uart_tx_buf[ uart ].tail >= UART_Buffer_Size )
-			uart_tx_buf[ uart ].tail = 0;
-		if ( uart_tx_buf[ uart ].head == uart_tx_buf[ uart ].tail )
-			uart_tx_buf[ uart ].head++;
-		if ( uart_tx_buf[ uart ].head >= UART_Buffer_Size )
-			uart_tx_buf[ uart ].head = 0;
+	// Idle bytes, no framing
+	if ( !isCommand )
+	{
+		Connect_txPush( status->frame, len, uart );
+		return;
+	}
+
+	// SYN, SOH, Length
+	uint8_t header[] = { Command_SYN, SOH, len - 2 };
+	uint8_t crc = Connect_crc8( 0, header[2] );
+	for ( uint16_t c = 2; c < len; c++ )
+	{
+		crc = Connect_crc8( crc, status->frame[ c ] );
 	}
+
+	Connect_txPush( header, sizeof( header ), uart );
+	Connect_txPush( &status->frame[2], len - 2, uart );
+	Connect_txPush( &crc, 1, uart );
 }
 
 
@@ -325,45 +481,163 @@ void Connect_send_IdReport( uint8_t id )
 	uart_unlockTx( UART_Master );
 }
 
+// version 0 disables ScanCodeCompact, 1 enables it
+// Nodes without ScanCodeCompact support ignore the command and don't propagate it,
+// so nodes past them keep sending ScanCode
+void Connect_send_CompactEnable( uint8_t version )
+{
+	// Lock slave bound Tx
+	uart_lockTx( UART_Slave );
+
+	// Prepare header
+	uint8_t header[] = { Command_SYN, SOH, CompactEnable, version };
+
+	// Send header
+	Connect_addBytes( header, sizeof( header ), UART_Slave );
+
+	// Unlock Tx
+	uart_unlockTx( UART_Slave );
+}
+
+// ScanCodeCompact encoding
+// Each Press/Release is stored as a varint (7 bits per byte, MSB set if another byte follows) of
+//  zigzag( index - previous index ) << 1 | release
+// The previous index starts at 0 for each message, events keep their original order
+// Keys changing near each other (or a single key) take 1 byte instead of 3
+#define Connect_ScanCodeCompactMaxBytes 255
+static uint8_t Connect_send_ScanCodeCompactBuffer[Connect_ScanCodeCompactMaxBytes];
+
+// Returns the number of bytes encoded into Connect_send_ScanCodeCompactBuffer
+// Returns 0 if the events can't be encoded (not Switch1 Press/Release, or too many)
+static uint8_t Connect_encode_ScanCodeCompact( TriggerEvent *scanCodeStateList, uint8_t numScanCodes )
+{
+	uint16_t pos = 0;
+	uint8_t prev = 0;
+
+	for ( uint8_t c = 0; c < numScanCodes; c++ )
+	{
+		TriggerEvent *event = &scanCodeStateList[ c ];
+
+		// Only Press/Release switch events can be encoded
+		if ( event->type != TriggerType_Switch1
+			|| ( event->state != ScheduleType_P && event->state != ScheduleType_R ) )
+		{
+			return 0;
+		}
+
+		int16_t delta = event->index - prev;
+		uint16_t value = delta < 0 ? ( -delta << 1 ) - 1 : delta << 1;
+		value = ( value << 1 ) | ( event->state == ScheduleType_R ? 1 : 0 );
+		prev = event->index;
+
+		// At most 2 bytes per event
+		if ( pos + 2 > Connect_ScanCodeCompactMaxBytes )
+			return 0;
+
+		while ( value >= 0x80 )
+		{
+			Connect_send_ScanCodeCompactBuffer[ pos++ ] = ( value & 0x7F ) | 0x80;
+			value >>= 7;
+		}
+		Connect_send_ScanCodeCompactBuffer[ pos++ ] = value;
+	}
+
+	return pos;
+}
+
 // id is the currently assigned id to the slave
 // scanCodeStateList is an array of [scancode, state]'s (8 bit values)
 // numScanCodes is the number of scan codes to parse from array
-void Connect_send_ScanCode( uint8_t id, TriggerEvent *scanCodeStateList, uint8_t numScanCodes )
+// Uses ScanCodeCompact if the master has enabled it, and all the events can be encoded
+// Returns 0 if the Tx buffer is backed up, and the caller should try again later
+uint8_t Connect_send_ScanCode( uint8_t id, TriggerEvent *scanCodeStateList, uint8_t numScanCodes )
 {
+	uint8_t numBytes = Connect_compact ? Connect_encode_ScanCodeCompact( scanCodeStateList, numScanCodes ) : 0;
+	uint8_t *payload = Connect_send_ScanCodeCompactBuffer;
+
+	// Prepare header
+	uint8_t header[] = { Command_SYN, SOH, ScanCodeCompact, id, numBytes };
+
+	// Fallback to uncompressed TriggerGuides
+	if ( numBytes == 0 )
+	{
+		header[2] = ScanCode;
+		header[4] = numScanCodes;
+		numBytes = numScanCodes * TriggerGuideSize;
+		payload = (uint8_t*)scanCodeStateList;
+	}
+
 	// Lock master bound Tx
 	uart_lockTx( UART_Master );
 
-	// Prepare header
-	uint8_t header[] = { Command_SYN, SOH, ScanCode, id, numScanCodes };
+	// Make sure there's room for the whole message
+	// Checked while locked, the Rx interrupt may forward a slave command into the ring before the lock is taken
+	if ( !Connect_txReady( UART_Master, sizeof( header ) + numBytes ) )
+	{
+		// Nothing was added to the frame, so unlocking queues nothing
+		uart_unlockTx( UART_Master );
+		return 0;
+	}
 
 	// Send header
 	Connect_addBytes( header, sizeof( header ), UART_Master );
 
 	// Send each of the scan codes
-	Connect_addBytes( (uint8_t*)scanCodeStateList, numScanCodes * TriggerGuideSize, UART_Master );
+	Connect_addBytes( payload, numBytes, UART_Master );
 
 	// Unlock Tx
 	uart_unlockTx( UART_Master );
+
+	Connect_scanCodeTxEvents += numScanCodes;
+	Connect_scanCodeTxBytes += sizeof( header ) + numBytes;
+	return 1;
 }
 
 // Send a remote capability command using capability index
 // This may not be what's expected (especially if the firmware is not the same on each node)
 // To broadcast to all slave nodes, set id to 255 instead of a specific id
-void Connect_send_RemoteCapability( uint8_t id, uint8_t capabilityIndex, uint8_t state, uint8_t stateType, uint8_t numArgs, uint8_t *args )
+// Returns 0 if the Tx buffer is backed up, and the caller should try again later
+uint8_t Connect_send_RemoteCapability( uint8_t id, uint8_t capabilityIndex, uint8_t state, uint8_t stateType, uint8_t numArgs, uint8_t *args )
 {
 	// Prepare header
 	uint8_t header[] = { Command_SYN, SOH, RemoteCapability, id, capabilityIndex, state, stateType, numArgs };
 
 	// Ignore current id
 	if ( id == Connect_id )
-		return;
+		return 1;
 
-	// Send towards slave node
-	if ( id > Connect_id )
+	// Lock the Tx of each direction the message is sent
+	uint8_t toSlave = id > Connect_id;
+	uint8_t toMaster = id < Connect_id || id == 255;
+	if ( toSlave && toMaster )
+	{
+		uart_lockBothTx( UART_Slave, UART_Master );
+	}
+	else if ( toSlave )
 	{
-		// Lock slave bound Tx
 		uart_lockTx( UART_Slave );
+	}
+	else
+	{
+		uart_lockTx( UART_Master );
+	}
+
+	// Make sure there's room for the whole message in each direction
+	// Checked while locked, the Rx interrupt may forward a command into the ring before the lock is taken
+	if ( ( toSlave && !Connect_txReady( UART_Slave, sizeof( header ) + numArgs ) )
+		|| ( toMaster && !Connect_txReady( UART_Master, sizeof( header ) + numArgs ) ) )
+	{
+		// Nothing was added to the frames, so unlocking queues nothing
+		if ( toSlave )
+			uart_unlockTx( UART_Slave );
+		if ( toMaster )
+			uart_unlockTx( UART_Master );
+		return 0;
+	}
 
+	// Send towards slave node
+	if ( toSlave )
+	{
 		// Send header
 		Connect_addBytes( header, sizeof( header ), UART_Slave );
 
@@ -375,11 +649,8 @@ void Connect_send_RemoteCapability( uint8_t id, uint8_t capabilityIndex, uint8_t
 	}
 
 	// Send towards master node
-	if ( id < Connect_id || id == 255 )
+	if ( toMaster )
 	{
-		// Lock slave bound Tx
-		uart_lockTx( UART_Master );
-
 		// Send header
 		Connect_addBytes( header, sizeof( header ), UART_Master );
 
@@ -389,6 +660,8 @@ void Connect_send_RemoteCapability( uint8_t id, uint8_t capabilityIndex, uint8_t
 		// Unlock Tx
 		uart_unlockTx( UART_Master );
 	}
+
+	return 1;
 }
 
 void Connect_send_Idle( uint8_t num )
@@ -614,6 +887,9 @@ uint8_t Connect_receive_IdReport( uint8_t id, uint16_t *pending_bytes, uint8_t u
 		// Send available current
 		Connect_currentChange( Output_current_available() );
 
+		// Enable ScanCodeCompact on the slave nodes
+		Connect_send_CompactEnable( 1 );
+
 		return 1;
 	}
 	// Propagate id if yet another slave
@@ -630,6 +906,42 @@ static TriggerGuide Connect_receive_ScanCodeBuffer;
 static uint8_t Connect_receive_ScanCodeBufferPos;
 static uint8_t Connect_receive_ScanCodeDeviceId;
 
+// Adjusts the ScanCode offset of the received TriggerGuide, then sends it to the Macro module
+static void Connect_receive_ScanCodeAdd()
+{
+	// Adjust ScanCode offset
+	if ( Connect_receive_ScanCodeDeviceId > 0 )
+	{
+		// Check if this node is too large
+		if ( Connect_receive_ScanCodeDeviceId >= InterconnectNodeMax )
+		{
+			warn_print("Not enough interconnect layout nodes configured: ");
+			printHex( Connect_receive_ScanCodeDeviceId );
+			print( NL );
+			return;
+		}
+
+		// This variable is in generatedKeymaps.h
+		extern uint8_t InterconnectOffsetList[];
+		Connect_receive_ScanCodeBuffer.scanCode = Connect_receive_ScanCodeBuffer.scanCode + InterconnectOffsetList[ Connect_receive_ScanCodeDeviceId ];
+	}
+
+	// ScanCode receive debug
+	if ( Connect_debug )
+	{
+		dbug_print("");
+		printHex( Connect_receive_ScanCodeBuffer.type );
+		print(" ");
+		printHex( Connect_receive_ScanCodeBuffer.state );
+		print(" ");
+		printHex( Connect_receive_ScanCodeBuffer.scanCode );
+		print( NL );
+	}
+
+	// Send ScanCode to macro module
+	Macro_pressReleaseAdd( &Connect_receive_ScanCodeBuffer );
+}
+
 uint8_t Connect_receive_ScanCode( uint8_t byte, uint16_t *pending_bytes, uint8_t uart_num )
 {
 	// Check the directionality
@@ -659,38 +971,7 @@ uint8_t Connect_receive_ScanCode( uint8_t byte, uint16_t *pending_bytes, uint8_t
 		if ( Connect_receive_ScanCodeBufferPos >= sizeof( TriggerGuide ) )
 		{
 			Connect_receive_ScanCodeBufferPos = 0;
-
-			// Adjust ScanCode offset
-			if ( Connect_receive_ScanCodeDeviceId > 0 )
-			{
-				// Check if this node is too large
-				if ( Connect_receive_ScanCodeDeviceId >= InterconnectNodeMax )
-				{
-					warn_print("Not enough interconnect layout nodes configured: ");
-					printHex( Connect_receive_ScanCodeDeviceId );
-					print( NL );
-					break;
-				}
-
-				// This variable is in generatedKeymaps.h
-				extern uint8_t InterconnectOffsetList[];
-				Connect_receive_ScanCodeBuffer.scanCode = Connect_receive_ScanCodeBuffer.scanCode + InterconnectOffsetList[ Connect_receive_ScanCodeDeviceId ];
-			}
-
-			// ScanCode receive debug
-			if ( Connect_debug )
-			{
-				dbug_print("");
-				printHex( Connect_receive_ScanCodeBuffer.type );
-				print(" ");
-				printHex( Connect_receive_ScanCodeBuffer.state );
-				print(" ");
-				printHex( Connect_receive_ScanCodeBuffer.scanCode );
-				print( NL );
-			}
-
-			// Send ScanCode to macro module
-			Macro_pressReleaseAdd( &Connect_receive_ScanCodeBuffer );
+			Connect_receive_ScanCodeAdd();
 		}
 
 		break;
@@ -718,6 +999,120 @@ uint8_t Connect_receive_ScanCode( uint8_t byte, uint16_t *pending_bytes, uint8_t
 
 		// Pass through byte
 		Connect_addBytes( &byte, 1, UART_Master );
+
+		// Unlock Tx Buffer if there are no TriggerGuides
+		if ( *pending_bytes == 0 )
+			uart_unlockTx( UART_Master );
+		break;
+
+	default:
+		// Pass through byte
+		Connect_addBytes( &byte, 1, UART_Master );
+
+		// Unlock Tx Buffer after sending last byte
+		if ( *pending_bytes == 0 )
+			uart_unlockTx( UART_Master );
+		break;
+	}
+
+	// Check whether the scan codes have finished sending
+	return *pending_bytes == 0 ? 1 : 0;
+}
+
+uint8_t Connect_receive_CompactEnable( uint8_t version, uint16_t *pending_bytes, uint8_t uart_num )
+{
+	// Check the directionality
+	if ( uart_num == UART_Slave )
+	{
+		erro_printNL("Invalid CompactEnable direction...");
+	}
+
+	// Only version 1 is supported
+	Connect_compact = version == 1 ? 1 : 0;
+
+	// Propagate to the next slave
+	if ( Connect_cableOkSlave )
+	{
+		Connect_send_CompactEnable( version );
+	}
+
+	return 1;
+}
+
+// - Scan Code Compact Variables -
+static uint16_t Connect_receive_ScanCodeCompactValue;
+static uint8_t Connect_receive_ScanCodeCompactShift;
+static uint8_t Connect_receive_ScanCodeCompactIndex;
+
+uint8_t Connect_receive_ScanCodeCompact( uint8_t byte, uint16_t *pending_bytes, uint8_t uart_num )
+{
+	// Check the directionality
+	if ( uart_num == UART_Master )
+	{
+		erro_printNL("Invalid ScanCodeCompact direction...");
+	}
+
+	// Master node, decode and trigger scan codes
+	if ( Connect_master ) switch ( (*pending_bytes)-- )
+	{
+	case BYTE_COUNT_START - 0: // Device Id
+		Connect_receive_ScanCodeDeviceId = byte;
+		break;
+
+	case BYTE_COUNT_START - 1: // Number of encoded bytes
+		*pending_bytes = byte;
+		Connect_receive_ScanCodeCompactValue = 0;
+		Connect_receive_ScanCodeCompactShift = 0;
+		Connect_receive_ScanCodeCompactIndex = 0;
+		break;
+
+	default:
+	{
+		// Accumulate varint (see Connect_encode_ScanCodeCompact)
+		Connect_receive_ScanCodeCompactValue |= ( byte & 0x7F ) << Connect_receive_ScanCodeCompactShift;
+		if ( ( byte & 0x80 ) && Connect_receive_ScanCodeCompactShift < 14 )
+		{
+			Connect_receive_ScanCodeCompactShift += 7;
+			break;
+		}
+
+		uint16_t value = Connect_receive_ScanCodeCompactValue;
+		uint16_t zigzag = value >> 1;
+		Connect_receive_ScanCodeCompactIndex += zigzag & 0x1 ? -( ( zigzag + 1 ) >> 1 ) : zigzag >> 1;
+		Connect_receive_ScanCodeCompactValue = 0;
+		Connect_receive_ScanCodeCompactShift = 0;
+
+		Connect_receive_ScanCodeBuffer.type = TriggerType_Switch1;
+		Connect_receive_ScanCodeBuffer.state = value & 0x1 ? ScheduleType_R : ScheduleType_P;
+		Connect_receive_ScanCodeBuffer.scanCode = Connect_receive_ScanCodeCompactIndex;
+		Connect_receive_ScanCodeAdd();
+		break;
+	}
+	}
+	// Propagate ScanCodeCompact packet
+	else switch ( (*pending_bytes)-- )
+	{
+	case BYTE_COUNT_START - 0: // Device Id
+	{
+		Connect_receive_ScanCodeDeviceId = byte;
+
+		// Lock the master Tx buffer
+		uart_lockTx( UART_Master );
+
+		// Send header + Id byte
+		uint8_t header[] = { Command_SYN, SOH, ScanCodeCompact, byte };
+		Connect_addBytes( header, sizeof( header ), UART_Master );
+		break;
+	}
+	case BYTE_COUNT_START - 1: // Number of encoded bytes
+		*pending_bytes = byte;
+
+		// Pass through byte
+		Connect_addBytes( &byte, 1, UART_Master );
+
+		// Unlock Tx Buffer if there are no encoded bytes
+		if ( *pending_bytes == 0 )
+			uart_unlockTx( UART_Master );
 		break;
 
 	default:
@@ -906,6 +1301,8 @@ void *Connect_receiveFunctions[] = {
 	Connect_receive_RemoteOutput,
 	Connect_receive_RemoteInput,
 	Connect_receive_CurrentEvent,
+	Connect_receive_CompactEnable,
+	Connect_receive_ScanCodeCompact,
 };
 
 
@@ -920,6 +1317,16 @@ void Connect_reset()
 
 	// Reset Tx
 	memset( (void*)uart_tx_buf,    0, sizeof( UARTRingBuf )  * UART_Num_Interfaces );
+	memset( (void*)Connect_txDropped, 0, sizeof( Connect_txDropped ) );
+	memset( (void*)Connect_rxFrames, 0, sizeof( Connect_rxFrames ) );
+	memset( (void*)Connect_rxCrcErrors, 0, sizeof( Connect_rxCrcErrors ) );
+	memset( (void*)Connect_rxFramingErrors, 0, sizeof( Connect_rxFramingErrors ) );
+	Connect_scanCodeTxEvents = 0;
+	Connect_scanCodeTxBytes = 0;
+	Connect_scanCodeTxDropped = 0;
+
+	// ScanCodeCompact is re-enabled by the master on enumeration
+	Connect_compact = 0;
 	memset( (void*)uart_tx_status, 0, sizeof( UARTStatusTx ) * UART_Num_Interfaces );
 
 	// Set Rx/Tx buffers as ready
@@ -1082,137 +1489,236 @@ void Connect_setup( uint8_t master, uint8_t first )
 	case x: \
 		pos = DMA_TCD##x##_CITER_ELINKNO; \
 		break
-void Connect_rx_process( uint8_t uartNum )
+// Frame failed verification
+// Replay the bytes following the next SYN (plus any bytes not yet replayed), the next frame may start there
+void Connect_rx_resync( uint8_t uartNum )
 {
-	// Determine current position to read until
-	uint16_t bufpos = 0;
-	switch ( uartNum )
+	volatile UARTStatusRx *rx = &uart_rx_status[ uartNum ];
+
+	// Find the next SYN in the received frame bytes
+	uint16_t start = 0;
+	while ( start < rx->frame_pos && rx->frame[ start ] != Command_SYN )
 	{
-#if defined(_kinetis_)
-	DMA_BUF_POS( 0, bufpos );
-	DMA_BUF_POS( 1, bufpos );
-#elif defined(_sam_)
-	//SAM TODO
-#endif
+		start++;
 	}
 
-	// Process each of the new bytes
-	// Even if we receive more bytes during processing, wait until the next check so we don't starve other tasks
-	while ( bufpos != uart_rx_buf[ uartNum ].last_read )
+	// Move the frame bytes (from the SYN), then the remaining replay bytes, to the start of the buffer
+	uint16_t len = rx->frame_pos - start;
+	uint16_t remaining = rx->replay_len - rx->replay_pos;
+	memmove( (uint8_t*)rx->frame, (uint8_t*)&rx->frame[ start ], len );
+	memmove( (uint8_t*)&rx->frame[ len ], (uint8_t*)&rx->frame[ rx->replay_pos ], remaining );
+
+	rx->replay_pos = 0;
+	rx->replay_len = len + remaining;
+	rx->frame_pos = 0;
+	rx->status = UARTStatus_Wait;
+}
+
+// Process a verified frame
+void Connect_rx_frame( uint8_t uartNum )
+{
+	volatile UARTStatusRx *rx = &uart_rx_status[ uartNum ];
+	uint8_t len = rx->frame[0];
+	uint8_t command = rx->frame[1];
+
+	Connect_rxFrames[ uartNum ]++;
+
+	// Ignore unknown commands (newer firmware)
+	if ( command >= Command_TOP )
 	{
-		// If the last_read byte is at the buffer edge, roll back to beginning
-		if ( uart_rx_buf[ uartNum ].last_read == 0 )
+		if ( Connect_debug )
 		{
-			uart_rx_buf[ uartNum ].last_read = UART_Buffer_Size;
+			print(" ### ");
+			printHex( command );
+		}
+		return;
+	}
 
-			// Check to see if we're at the boundary
-			if ( bufpos == UART_Buffer_Size )
-				break;
+	rx->status = UARTStatus_Command;
+	rx->command = command;
+	rx->bytes_waiting = BYTE_COUNT_START;
+
+	// Check if this is a very short packet
+	if ( command == IdRequest )
+	{
+		Connect_receive_IdRequest( 0, (uint16_t*)&rx->bytes_waiting, uartNum );
+		return;
+	}
+
+	// Call specific UARTConnect command receive function for each data byte
+	// Until the Command has received all the bytes it requires
+	uint8_t (*rcvFunc)(uint8_t, uint16_t(*), uint8_t) = (uint8_t(*)(uint8_t, uint16_t(*), uint8_t))(Connect_receiveFunctions[ command ]);
+	for ( uint16_t pos = 2; pos <= len; pos++ )
+	{
+		if ( rcvFunc( rx->frame[ pos ], (uint16_t*)&rx->bytes_waiting, uartNum ) )
+			return;
+	}
+
+	// Frame was shorter than the command expected
+	Connect_rxFramingErrors[ uartNum ]++;
+
+	// Forwarding commands lock the master bound Tx on their first byte, and only unlock after their last byte
+	// Discard the partial command and release the lock, otherwise the next uart_lockTx never returns
+	if ( !Connect_master && len >= 2 && ( command == ScanCode || command == ScanCodeCompact ) )
+	{
+		uart_tx_status[ UART_Master ].frame_len = 0;
+		uart_unlockTx( UART_Master );
+	}
+
+	// Reset command state
+	rx->bytes_waiting = 0;
+	Connect_receive_ScanCodeBufferPos = 0;
+	if ( Connect_debug )
+	{
+		warn_printNL("Incomplete command...");
+	}
+}
+
+// Process a single Rx byte
+void Connect_rx_byte( uint8_t uartNum, uint8_t byte )
+{
+	volatile UARTStatusRx *rx = &uart_rx_status[ uartNum ];
+
+	switch ( rx->status )
+	{
+	// Every packet must start with a SYN / 0x16
+	case UARTStatus_Wait:
+		if ( Connect_debug )
+		{
+			print(" Wait ");
 		}
+		rx->status = byte == Command_SYN ? UARTStatus_SYN : UARTStatus_Wait;
+		break;
 
-		// Read the byte out of Rx DMA buffer
-		uint8_t byte = uart_rx_buf[ uartNum ].buffer[ UART_Buffer_Size - uart_rx_buf[ uartNum ].last_read-- ];
+	// After a SYN, there must be a SOH / 0x01
+	// Repeated SYNs (e.g. Idle) keep waiting for the SOH
+	case UARTStatus_SYN:
+		if ( Connect_debug )
+		{
+			print(" SYN ");
+		}
+		rx->status = byte == SOH ? UARTStatus_SOH : byte == Command_SYN ? UARTStatus_SYN : UARTStatus_Wait;
+		break;
 
+	// After a SOH is the frame length (Command + Data)
+	case UARTStatus_SOH:
 		if ( Connect_debug )
 		{
-			printHex( byte );
-			print(" ");
+			print(" SOH ");
 		}
+		rx->frame[0] = byte;
+		rx->frame_pos = 1;
 
-		// Process UART byte
-		switch ( uart_rx_status[ uartNum ].status )
+		// Frame must fit into the buffer (Length + Command + Data + CRC)
+		if ( byte == 0 || byte > UART_Buffer_Size - FRAME_OVERHEAD )
 		{
-		// Every packet must start with a SYN / 0x16
-		case UARTStatus_Wait:
-			if ( Connect_debug )
-			{
-				print(" Wait ");
-			}
-			uart_rx_status[ uartNum ].status = byte == Command_SYN ? UARTStatus_SYN : UARTStatus_Wait;
+			Connect_rxFramingErrors[ uartNum ]++;
+			Connect_rx_resync( uartNum );
 			break;
+		}
+
+		rx->crc = Connect_crc8( 0, byte );
+		rx->status = UARTStatus_Frame;
+		break;
+
+	// Buffer Command + Data
+	case UARTStatus_Frame:
+		rx->frame[ rx->frame_pos ] = byte;
+		rx->crc = Connect_crc8( rx->crc, byte );
+		if ( rx->frame_pos++ == rx->frame[0] )
+		{
+			rx->status = UARTStatus_CRC;
+		}
+		break;
 
-		// After a SYN, there must be a SOH / 0x01
-		case UARTStatus_SYN:
+	// Verify the frame before processing
+	case UARTStatus_CRC:
+		rx->frame[ rx->frame_pos++ ] = byte;
+		if ( byte != rx->crc )
+		{
+			Connect_rxCrcErrors[ uartNum ]++;
 			if ( Connect_debug )
 			{
-				print(" SYN ");
+				warn_print("CRC mismatch ");
+				printHex( byte );
+				print("/");
+				printHex( rx->crc );
+				print( NL );
 			}
-			uart_rx_status[ uartNum ].status = byte == SOH ? UARTStatus_SOH : UARTStatus_Wait;
+			Connect_rx_resync( uartNum );
 			break;
+		}
 
-		// After a SOH the packet structure may diverge a bit
-		// This is the packet type field (refer to the Command enum)
-		// For very small packets (e.g. IdRequest) this is all that's required to take action
-		case UARTStatus_SOH:
+		if ( Connect_debug )
 		{
-			if ( Connect_debug )
-			{
-				print(" SOH ");
-			}
+			print(" CMD ");
+		}
+		Connect_rx_frame( uartNum );
+		rx->status = UARTStatus_Wait;
+		break;
 
-			// Check if this is actually a reserved CMD 0x16 (Error condition)
-			if ( byte == Command_SYN )
-			{
-				uart_rx_status[ uartNum ].status = UARTStatus_SYN;
-				break;
-			}
+	// Unknown status, should never get here
+	default:
+		erro_print("Invalid UARTStatus...");
+		rx->status = UARTStatus_Wait;
+		break;
+	}
+}
 
-			// Otherwise process the command
-			if ( byte < Command_TOP )
-			{
-				uart_rx_status[ uartNum ].status = UARTStatus_Command;
-				uart_rx_status[ uartNum ].command = byte;
-				uart_rx_status[ uartNum ].bytes_waiting = BYTE_COUNT_START;
-			}
-			// Invalid packet type, ignore
-			else
-			{
-				uart_rx_status[ uartNum ].status = UARTStatus_Wait;
-			}
+void Connect_rx_process( uint8_t uartNum )
+{
+	// Determine current position to read until
+	uint16_t bufpos = 0;
+	switch ( uartNum )
+	{
+#if defined(_kinetis_)
+	DMA_BUF_POS( 0, bufpos );
+	DMA_BUF_POS( 1, bufpos );
+#elif defined(_sam_)
+	//SAM TODO
+#endif
+	}
 
-			// Check if this is a very short packet
-			switch ( uart_rx_status[ uartNum ].command )
-			{
-			case IdRequest:
-				Connect_receive_IdRequest( 0, (uint16_t*)&uart_rx_status[ uartNum ].bytes_waiting, uartNum );
-				uart_rx_status[ uartNum ].status = UARTStatus_Wait;
-				break;
+	// Process each of the new bytes
+	// Even if we receive more bytes during processing, wait until the next check so we don't starve other tasks
+	volatile UARTStatusRx *rx = &uart_rx_status[ uartNum ];
+	while ( 1 )
+	{
+		uint8_t byte;
 
-			default:
-				if ( Connect_debug )
-				{
-					print(" ### ");
-					printHex( uart_rx_status[ uartNum ].command );
-				}
-				break;
-			}
-			break;
+		// Replay bytes after a failed frame first
+		if ( rx->replay_pos < rx->replay_len )
+		{
+			byte = rx->frame[ rx->replay_pos++ ];
 		}
-
-		// After the packet type has been deciphered do Command specific processing
-		// Until the Command has received all the bytes it requires the UART buffer stays in this state
-		case UARTStatus_Command:
+		else
 		{
-			if ( Connect_debug )
-			{
-				print(" CMD ");
-			}
-			/* Call specific UARTConnect command receive function */
-			uint8_t (*rcvFunc)(uint8_t, uint16_t(*), uint8_t) = (uint8_t(*)(uint8_t, uint16_t(*), uint8_t))(Connect_receiveFunctions[ uart_rx_status[ uartNum ].command ]);
-			if ( rcvFunc( byte, (uint16_t*)&uart_rx_status[ uartNum ].bytes_waiting, uartNum ) )
+			if ( bufpos == uart_rx_buf[ uartNum ].last_read )
+				break;
+
+			// If the last_read byte is at the buffer edge, roll back to beginning
+			if ( uart_rx_buf[ uartNum ].last_read == 0 )
 			{
-				uart_rx_status[ uartNum ].status = UARTStatus_Wait;
+				uart_rx_buf[ uartNum ].last_read = UART_Buffer_Size;
+
+				// Check to see if we're at the boundary
+				if ( bufpos == UART_Buffer_Size )
+					break;
 			}
-			break;
+
+			// Read the byte out of Rx DMA buffer
+			byte = uart_rx_buf[ uartNum ].buffer[ UART_Buffer_Size - uart_rx_buf[ uartNum ].last_read-- ];
 		}
 
-		// Unknown status, should never get here
-		default:
-			erro_print("Invalid UARTStatus...");
-			uart_rx_status[ uartNum ].status = UARTStatus_Wait;
-			continue;
+		if ( Connect_debug )
+		{
+			printHex( byte );
+			print(" ");
 		}
 
+		// Process UART byte
+		Connect_rx_byte( uartNum, byte );
+
 		if ( Connect_debug )
 		{
 			print( NL );
@@ -1220,7 +1726,6 @@ void Connect_rx_process( uint8_t uartNum )
 	}
 }
 
-
 // Scan for updates in the master/slave
 // - Interrupts will deal with most input functions
 // - Used to send queries
@@ -1266,9 +1771,9 @@ void Connect_scan()
 		// Check if Tx Buffers are empty and the Tx Ring buffers have data to send
 		// This happens if there was previously nothing to send
 #if defined(_kinetis_)
-		if ( uart_tx_buf[ 0 ].items > 0 && UART0_TCFIFO == 0 )
+		if ( Connect_txItems( 0 ) > 0 && UART0_TCFIFO == 0 )
 			uart_fillTxFifo( 0 );
-		if ( uart_tx_buf[ 1 ].items > 0 && UART1_TCFIFO == 0 )
+		if ( Connect_txItems( 1 ) > 0 && UART1_TCFIFO == 0 )
 			uart_fillTxFifo( 1 );
 #elif defined(_sam_)
 		//SAM TODO
@@ -1361,6 +1866,20 @@ void cliFunc_connectCmd( char* args )
 		Connect_send_CurrentEvent( 250 );
 		break;
 
+	case CompactEnable:
+		Connect_send_CompactEnable( 1 );
+		break;
+
+	case ScanCodeCompact:
+	{
+		TriggerEvent scanCodes[] = { { 0x00, 0x01, 0x05 }, { 0x00, 0x03, 0x16 } };
+		uint8_t compact = Connect_compact;
+		Connect_compact = 1;
+		Connect_send_ScanCode( 10, scanCodes, 2 );
+		Connect_compact = compact;
+		break;
+	}
+
 	default:
 		break;
 	}
@@ -1404,6 +1923,8 @@ void cliFunc_connectLst( char* args )
 		"RemoteOutput",
 		"RemoteInput",
 		"CurrentEvent",
+		"CompactEnable",
+		"ScanCodeCompact",
 	};
 
 	print( NL );
@@ -1473,6 +1994,15 @@ void cliFunc_connectSts( char* args )
 	printHex( Connect_id );
 	print( NL "Max Id:\t" );
 	printHex( Connect_maxId );
+	print( NL "Compact:\t" );
+	printHex( Connect_compact );
+	print( NL "ScanCode Tx:\t" );
+	printInt32( Connect_scanCodeTxEvents );
+	print(" events/");
+	printInt32( Connect_scanCodeTxBytes );
+	print(" bytes");
+	print( NL "ScanCode Drop:\t" );
+	printInt32( Connect_scanCodeTxDropped );
 	print( NL "Master <=" NL "\tStatus:\t");
 	printHex( Connect_cableOkMaster );
 	print( NL "\tFaults:\t");
@@ -1483,6 +2013,14 @@ void cliFunc_connectSts( char* args )
 	printHex( uart_rx_status[UART_Master].status );
 	print( NL "\tTx:\t");
 	printHex( uart_tx_status[UART_Master].status );
+	print( NL "\tTx Dropped:\t");
+	printInt32( Connect_txDropped[UART_Master] );
+	print( NL "\tRx Frames:\t");
+	printInt32( Connect_rxFrames[UART_Master] );
+	print( NL "\tCRC Errors:\t");
+	printInt32( Connect_rxCrcErrors[UART_Master] );
+	print( NL "\tFraming Errors:\t");
+	printInt32( Connect_rxFramingErrors[UART_Master] );
 	print( NL "Slave <=" NL "\tStatus:\t");
 	printHex( Connect_cableOkSlave );
 	print( NL "\tFaults:\t");
@@ -1493,5 +2031,13 @@ void cliFunc_connectSts( char* args )
 	printHex( uart_rx_status[UART_Slave].status );
 	print( NL "\tTx:\t");
 	printHex( uart_tx_status[UART_Slave].status );
+	print( NL "\tTx Dropped:\t");
+	printInt32( Connect_txDropped[UART_Slave] );
+	print( NL "\tRx Frames:\t");
+	printInt32( Connect_rxFrames[UART_Slave] );
+	print( NL "\tCRC Errors:\t");
+	printInt32( Connect_rxCrcErrors[UART_Slave] );
+	print( NL "\tFraming Errors:\t");
+	printInt32( Connect_rxFramingErrors[UART_Slave] );
 }
 
@@ -29,6 +29,9 @@
 #define CABLE_CHECK_ARG 0xD2
 #define BYTE_COUNT_START 0xFFFF
 
+// Frame overhead added to each command (length byte and CRC-8 trailer)
+#define FRAME_OVERHEAD 2
+
 // Node id's
 #define MASTER_ID 0x00
 #define DEFAULT_SLAVE_ID 0xFF
@@ -52,6 +55,9 @@ typedef enum Command {
 
 	CurrentEvent,     // Signals a current usage event
 
+	CompactEnable,    // Enables ScanCodeCompact on slave nodes (sent by master)
+	ScanCodeCompact,  // ScanCode Press/Release changes, delta encoded
+
 	Command_TOP,      // Enum bounds
 	Command_SYN = 0x16, // Reserved for error handling
 } Command;
@@ -60,9 +66,11 @@ typedef enum Command {
 typedef enum UARTStatus {
 	UARTStatus_Wait    = 0, // Waiting  Rx: for SYN  Tx: for current command copy to finish
 	UARTStatus_SYN     = 1, // Rx: SYN Received, waiting for SOH
-	UARTStatus_SOH     = 2, // Rx: SOH Received, waiting for Command
-	UARTStatus_Command = 3, // Rx: Command Received, waiting for data
+	UARTStatus_SOH     = 2, // Rx: SOH Received, waiting for frame length
+	UARTStatus_Command = 3, // Rx: Frame verified, processing Command
 	UARTStatus_Ready   = 4, // Tx: Ready to send commands
+	UARTStatus_Frame   = 5, // Rx: Length Received, waiting for Command and data
+	UARTStatus_CRC     = 6, // Rx: Frame Received, waiting for CRC
 } UARTStatus;
 
 
@@ -70,6 +78,10 @@ typedef enum UARTStatus {
 // ----- Structs -----
 
 // UART Connect Commands
+// Each command is sent as a frame
+//  SYN, SOH, Length, Command, Data..., CRC-8
+// Length counts the Command and Data bytes, the CRC-8 (poly 0x07) covers Length, Command and Data
+// Frames are only processed once the CRC has been verified
 
 // Cable Check Command
 // Called on each UART every few seconds to make sure there is a connection
@@ -156,12 +168,31 @@ typedef struct CurrentEventCommand {
 	uint16_t current; // Current usable on the bus
 } CurrentEventCommand;
 
+// Compact Enable Command
+// Initiated by the master whenever a slave reports its Id, propagated by each slave
+// Version 1 enables ScanCodeCompact, 0 disables it
+typedef struct CompactEnableCommand {
+	Command command;
+	uint8_t version;
+} CompactEnableCommand;
+
+// Scan Code Compact Command
+// Replaces the Scan Code Command once enabled by the master
+// Only Switch1 Press/Release changes, each a varint of zigzag( index delta ) << 1 | release
+typedef struct ScanCodeCompactCommand {
+	Command command;
+	uint8_t id;
+	uint8_t numBytes;
+	uint8_t firstByte[0];
+} ScanCodeCompactCommand;
+
 
 
 // ----- Variables -----
 
 extern uint8_t Connect_id;
 extern uint8_t Connect_master; // Set if master
+extern uint32_t Connect_scanCodeTxDropped; // ScanCode events dropped while the master bound Tx was backed up
 
 
 
@@ -171,8 +202,8 @@ void Connect_setup( uint8_t master, uint8_t first );
 void Connect_scan();
 void Connect_reset();
 
-void Connect_send_ScanCode( uint8_t id, TriggerEvent *scanCodeStateList, uint8_t numScanCodes );
-void Connect_send_RemoteCapability( uint8_t id, uint8_t capabilityIndex, uint8_t state, uint8_t stateType, uint8_t numArgs, uint8_t *args );
+uint8_t Connect_send_ScanCode( uint8_t id, TriggerEvent *scanCodeStateList, uint8_t numScanCodes );
+uint8_t Connect_send_RemoteCapability( uint8_t id, uint8_t capabilityIndex, uint8_t state, uint8_t stateType, uint8_t numArgs, uint8_t *args );
 
 void Connect_currentChange( unsigned int current );
 
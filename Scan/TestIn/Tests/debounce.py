@@ -0,0 +1,338 @@
+#!/usr/bin/env python3
+'''
+Matrix debounce regression test for Host-side KLL
+Compares event-driven strobe scanning against scanning every key on every strobe
+Compares the bit-sliced debounce engine against a per-key integrator
+'''
+
+# Copyright (C) 2021 by Jacob Alexander
+#
+# This file is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This file is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this file.  If not, see <http://www.gnu.org/licenses/>.
+
+### Imports ###
+
+import logging
+import os
+import random
+
+from ctypes import (
+    byref,
+    c_uint8,
+    c_uint32,
+    sizeof,
+    Structure,
+)
+
+import interface as i
+import kiilogger
+
+from common import (check, result, header)
+
+
+
+### Setup ###
+
+# Logger (current file and parent directory only)
+logger = kiilogger.get_logger(os.path.join(os.path.split(__file__)[0], os.path.basename(__file__)))
+logging.root.setLevel(logging.INFO)
+
+kiibohd = i.control.kiibohd
+kiibohd.Debounce_lastDecision.restype = c_uint32
+kiibohd.Debounce_strobe.restype = c_uint32
+kiibohd.Debounce_bitStrobe.restype = c_uint32
+kiibohd.Debounce_bitCount.restype = c_uint8
+
+# Simulated matrix
+strobes = 6
+senses = 8
+expiry = 6         # ms, MinDebounceTime default
+duration = 3000    # ms
+scans_per_ms = 2   # Full matrix scans per ms
+
+# Off, Press, Hold, Release
+off = 0
+
+
+
+### Structs ###
+
+class KeyState(Structure):
+    '''
+    KeyState struct
+    See debounce.h in Scan/Devices/MatrixARMPeriodic
+    '''
+    _fields_ = [
+        ('activeCount', c_uint8),
+        ('inactiveCount', c_uint8),
+        ('prevState', c_uint8),
+        ('curState', c_uint8),
+        ('prevDecisionTime', c_uint32),
+    ]
+
+
+class DebounceStrobe(Structure):
+    '''
+    DebounceStrobe struct
+    See debounce.h in Scan/Devices/MatrixARMPeriodic
+    '''
+    _fields_ = [
+        ('idle', c_uint32),
+        ('scanTime', c_uint32),
+    ]
+
+
+class DebounceBitStrobe(Structure):
+    '''
+    DebounceBitStrobe struct
+    See debounce.h in Scan/Devices/MatrixARMPeriodic (DebounceBitPlanes 4)
+    '''
+    _fields_ = [
+        ('state', c_uint32),
+        ('count', c_uint32 * 4),
+        ('sampleTime', c_uint32),
+    ]
+
+
+
+### Classes ###
+
+class Matrix:
+    '''
+    Debounce state of a simulated matrix
+    '''
+    def __init__(self, event_driven):
+        '''
+        @param event_driven: Enable event-driven strobe scanning
+        '''
+        self.event_driven = event_driven
+        self.keys = (KeyState * (strobes * senses))()
+        self.strobes = (DebounceStrobe * strobes)()
+        self.macro_calls = 0
+
+        for key in self.keys:
+            kiibohd.Debounce_keySetup(byref(key))
+        for strobe in self.strobes:
+            kiibohd.Debounce_strobeSetup(byref(strobe))
+
+    def scan(self, strobe, sense_word, time):
+        '''
+        Debounce a single strobe
+
+        @return: List of (sense, state) sent to the macro module (ignoring Off), sense lines with a decision
+        '''
+        decided = c_uint32(0)
+        evaluated = kiibohd.Debounce_strobe(
+            byref(self.strobes[strobe]),
+            byref(self.keys, strobe * sizeof(KeyState)),
+            c_uint8(strobes),
+            c_uint32((1 << senses) - 1),
+            c_uint32(sense_word),
+            c_uint32(time),
+            c_uint8(expiry),
+            c_uint8(self.event_driven),
+            byref(decided),
+        )
+
+        events = []
+        for sense in range(senses):
+            if evaluated & (1 << sense):
+                self.macro_calls += 1
+                state = self.keys[sense * strobes + strobe].curState
+                if state != off:
+                    events.append((sense, state))
+        return events, decided.value
+
+    def state(self, strobe):
+        '''
+        Visible debounce state of each key of a strobe
+        '''
+        state = []
+        for sense in range(senses):
+            key = self.keys[sense * strobes + strobe]
+            state.append((
+                key.activeCount,
+                key.inactiveCount,
+                key.prevState,
+                key.curState,
+                kiibohd.Debounce_lastDecision(byref(self.strobes[strobe]), byref(key), c_uint8(sense)),
+            ))
+        return state
+
+
+
+class IntegratorMatrix:
+    '''
+    Per-key reference of the bit-sliced debounce engine
+    A key changes state once it has disagreed with its debounced state for expiry ms ticks in a row
+    '''
+    def __init__(self):
+        self.state = [0] * (strobes * senses)
+        self.count = [0] * (strobes * senses)
+        self.sample_time = [0] * strobes
+
+    def scan(self, strobe, sense_word, time):
+        '''
+        Debounce a single strobe
+
+        @return: Sense lines whose debounced state changed
+        '''
+        tick = self.sample_time[strobe] != time
+        self.sample_time[strobe] = time
+
+        changed = 0
+        for sense in range(senses):
+            key = sense * strobes + strobe
+            if (sense_word >> sense) & 1 == self.state[key]:
+                self.count[key] = 0
+                continue
+            if tick:
+                self.count[key] += 1
+            if self.count[key] == expiry:
+                self.state[key] ^= 1
+                self.count[key] = 0
+                changed |= 1 << sense
+        return changed
+
+
+
+### Functions ###
+
+def signal_schedule(rand):
+    '''
+    Generate a bouncy press/release schedule for every key
+
+    @return: Per key list of (start scan, end scan) detected intervals
+    '''
+    total = duration * scans_per_ms
+    schedule = []
+    for _ in range(strobes * senses):
+        intervals = []
+        pos = rand.randrange(0, total // 4)
+        while pos < total:
+            # Key press with switch bounce on press and release
+            held = rand.randrange(1, 200)
+            for _ in range(rand.randrange(0, 4)):
+                intervals.append((pos, pos + rand.randrange(1, 3)))
+                pos += rand.randrange(2, 5)
+            intervals.append((pos, pos + held))
+            pos += held
+            for _ in range(rand.randrange(0, 4)):
+                pos += rand.randrange(2, 5)
+                intervals.append((pos, pos + rand.randrange(1, 3)))
+            # Idle time
+            pos += rand.randrange(10, 600)
+        schedule.append(intervals)
+    return schedule
+
+
+def sense_word(schedule, strobe, scan):
+    '''
+    Sense line readings of a strobe at the given scan
+    '''
+    word = 0
+    for sense in range(senses):
+        for start, end in schedule[sense * strobes + strobe]:
+            if start <= scan < end:
+                word |= 1 << sense
+                break
+    return word
+
+
+
+### Test ###
+
+logger.info(header("-- Event-driven matrix scan regression --"))
+
+schedule = signal_schedule(random.Random(0x4b4c4c))
+full = Matrix(0)
+event = Matrix(1)
+
+mismatches = 0
+presses = 0
+for scan in range(duration * scans_per_ms):
+    time = scan // scans_per_ms
+    for strobe in range(strobes):
+        word = sense_word(schedule, strobe, scan)
+        full_events, full_decided = full.scan(strobe, word, time)
+        event_events, event_decided = event.scan(strobe, word, time)
+
+        presses += len([e for e in full_events if e[1] == 1])
+
+        # Every non-Off state sent to the macro module must match
+        # Decisions must match for every key that was evaluated in event-driven mode
+        # Debounce state of every key must match
+        if (
+            full_events != event_events
+            or event_decided & ~full_decided
+            or full.state(strobe) != event.state(strobe)
+        ):
+            mismatches += 1
+            if mismatches < 10:
+                logger.warning("Scan {} strobe {}: {} != {}", scan, strobe, full_events, event_events)
+
+check(mismatches == 0)
+check(presses > 0)
+
+logger.info("Presses:                    {}", presses)
+logger.info("Macro calls (every key):    {}", full.macro_calls)
+logger.info("Macro calls (event-driven): {}", event.macro_calls)
+check(event.macro_calls < full.macro_calls)
+
+
+
+logger.info(header("-- Bit-sliced debounce engine --"))
+
+reference = IntegratorMatrix()
+bit_strobes = (DebounceBitStrobe * strobes)()
+for strobe in bit_strobes:
+    kiibohd.Debounce_bitStrobeSetup(byref(strobe))
+
+mismatches = 0
+presses = 0
+for scan in range(duration * scans_per_ms):
+    time = scan // scans_per_ms
+    for strobe in range(strobes):
+        word = sense_word(schedule, strobe, scan)
+        changed = kiibohd.Debounce_bitStrobe(
+            byref(bit_strobes[strobe]),
+            c_uint32(word),
+            c_uint32(time),
+            c_uint8(expiry),
+        )
+        presses += bin(changed & bit_strobes[strobe].state).count('1')
+
+        # Changes, debounced state and counters must match the per-key integrator
+        expected = reference.scan(strobe, word, time)
+        state = sum(reference.state[sense * strobes + strobe] << sense for sense in range(senses))
+        counts = [reference.count[sense * strobes + strobe] for sense in range(senses)]
+        if (
+            changed != expected
+            or bit_strobes[strobe].state != state
+            or [kiibohd.Debounce_bitCount(byref(bit_strobes[strobe]), c_uint8(sense)) for sense in range(senses)] != counts
+        ):
+            mismatches += 1
+            if mismatches < 10:
+                logger.warning("Scan {} strobe {}: {:x} != {:x}", scan, strobe, changed, expected)
+
+check(mismatches == 0)
+check(presses > 0)
+
+logger.info("Presses (bit-sliced):       {}", presses)
+logger.info("RAM per strobe:             {} bytes (per-key {} bytes)", sizeof(DebounceBitStrobe), sizeof(KeyState) * senses)
+
+
+
+### Results ###
+
+result()
@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+'''
+Fade lookup table test and benchmark for Host-side KLL
+'''
+
+# Copyright (C) 2020 by Jacob Alexander
+#
+# This file is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This file is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this file.  If not, see <http://www.gnu.org/licenses/>.
+
+### Imports ###
+
+import logging
+import os
+import time
+
+from ctypes import (
+    c_uint8,
+)
+
+import interface as i
+import kiilogger
+
+from common import (check, result, header)
+
+
+
+### Setup ###
+
+# Logger (current file and parent directory only)
+logger = kiilogger.get_logger(os.path.join(os.path.split(__file__)[0], os.path.basename(__file__)))
+logging.root.setLevel(logging.INFO)
+
+# Number of benchmark rounds (each round re-processes every channel)
+rounds = 200
+
+# Number of frames to step through for each profile setting (fade position changes every frame)
+frames = 8
+
+kiibohd = i.control.kiibohd
+kiibohd.Pixel_fadeLookup.restype = c_uint8
+kiibohd.Pixel_fadeValue.restype = c_uint8
+
+# Pixel_TotalChannels_KLL
+channels = 576
+
+# Press (Switch1), used to trigger capabilities
+press = (c_uint8(0x01), c_uint8(0x00))
+
+
+
+### Functions ###
+
+def gamma(enable):
+    '''
+    Enable/disable gamma correction
+
+    @param enable: 0 - Disabled, 1 - Enabled
+    '''
+    kiibohd.Pixel_GammaControl_capability(None, *press, (c_uint8 * 1)(enable))
+
+
+def brightness(profile, value):
+    '''
+    Set fade profile brightness (PixelFadeControl_Brightness_Set)
+
+    @param profile: Fade profile (0 indexed)
+    @param value:   Brightness
+    '''
+    kiibohd.Pixel_FadeControl_capability(None, *press, (c_uint8 * 3)(profile, 2, value))
+
+
+def lookup_all(func, profile):
+    '''
+    Fade every channel value using the given function
+
+    @param func:    Fade function
+    @param profile: Fade profile (0 indexed)
+
+    @return: List of faded values
+    '''
+    return [func(c_uint8(profile), c_uint8(val)) for val in range(256)]
+
+
+def bench():
+    '''
+    Time PixelMap secondary processing (fade, brightness and gamma), re-processing every channel each frame
+
+    @return: ns per frame
+    '''
+    start = time.perf_counter()
+    for _ in range(rounds):
+        kiibohd.Pixel_bufferRefresh()
+        kiibohd.Pixel_SecondaryProcessing()
+    return (time.perf_counter() - start) * 1e9 / rounds
+
+
+
+### Test ###
+
+logger.info(header("-- Fade lookup table --"))
+
+# Check the lookup table against the direct calculation for each setting
+# Each frame advances the fade position of every profile
+for enable in (0, 1):
+    gamma(enable)
+    for value in (0, 77, 255):
+        for profile in range(4):
+            brightness(profile, value)
+        for frame in range(frames):
+            for profile in range(4):
+                check(lookup_all(kiibohd.Pixel_fadeLookup, profile) == lookup_all(kiibohd.Pixel_fadeValue, profile))
+            kiibohd.Pixel_SecondaryProcessing()
+
+# Benchmark (gamma enabled, fading)
+logger.info(header("-- Fade benchmark ({} channels) --".format(channels)))
+gamma(1)
+brightness(0, 200)
+
+frame = bench()
+logger.info("Secondary processing: {:.1f} ns/frame ({:.1f} ns/channel)", frame, frame / channels)
+
+# Cleanup (restore default fade and gamma settings)
+kiibohd.Pixel_SecondaryProcessing_setup()
+for profile in range(4):
+    check(lookup_all(kiibohd.Pixel_fadeLookup, profile) == lookup_all(kiibohd.Pixel_fadeValue, profile))
+
+
+
+### Results ###
+
+result()
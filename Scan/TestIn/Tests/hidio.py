@@ -24,6 +24,10 @@ import logging
 import os
 import time
 
+from ctypes import (
+    c_uint32,
+)
+
 import interface as i
 import kiilogger
 
@@ -41,6 +45,12 @@ logging.root.setLevel(logging.INFO)
 # Reference to callback datastructure
 data = i.control.data
 
+kiibohd = i.control.kiibohd
+
+# HIDIO_TxWindow and HIDIO_TxTimeout (ms)
+tx_window = 4
+tx_timeout = 100
+
 
 
 ### Test ###
@@ -321,6 +331,88 @@ check( len( data.rawio_outgoing_buffer ) == 0 )
 
 
 
+# Sliding Window Test
+print("")
+logger.info(header("- Sliding Window Test -"))
+for _ in range( tx_window + 2 ):
+	i.control.cmd('HIDIO_test_2_request')( 1, 0x42 )
+
+
+# A single processing loop (receives, then sends packets)
+# Only a full window of messages may be waiting for an ACK
+i.control.loop(1)
+logger.info(header("Check window data packets"))
+logger.info("Outgoing Buf: {}", data.rawio_outgoing_buffer)
+check( len( data.rawio_outgoing_buffer ) == tx_window )
+for packet in data.rawio_outgoing_buffer:
+	check( packet[0].type == 0 )
+	check( packet[1] == 2 ) # Id check
+
+
+# A single processing loop (receives, then sends packets)
+i.control.loop(1)
+logger.info(header("Check window ACK packets"))
+logger.info("Outgoing Buf: {}", data.rawio_outgoing_buffer)
+check( len( data.rawio_outgoing_buffer ) == tx_window )
+for packet in data.rawio_outgoing_buffer:
+	check( packet[0].type == 1 )
+
+
+# A single processing loop (receives, then sends packets)
+# ACKs release the window, remaining messages are sent
+i.control.loop(1)
+logger.info(header("Check remaining data packets"))
+logger.info("Outgoing Buf: {}", data.rawio_outgoing_buffer)
+check( len( data.rawio_outgoing_buffer ) == 2 )
+for packet in data.rawio_outgoing_buffer:
+	check( packet[0].type == 0 )
+
+# ACKs, then empty
+i.control.loop(2)
+logger.info(header("Check buffers are empty"))
+check( len( data.rawio_incoming_buffer ) == 0 )
+check( len( data.rawio_outgoing_buffer ) == 0 )
+
+
+
+# Retransmit Test
+print("")
+logger.info(header("- Retransmit Test -"))
+kiibohd.Host_set_systick( c_uint32( 1000 ) )
+i.control.cmd('HIDIO_test_2_request')( 1, 0x42 )
+
+
+# A single processing loop (receives, then sends packets)
+i.control.loop(1)
+logger.info(header("Drop data packet"))
+check( len( data.rawio_outgoing_buffer ) == 1 )
+data.rawio_outgoing_buffer.clear()
+
+
+# Nothing is re-sent until the timeout expires
+i.control.loop(1)
+check( len( data.rawio_outgoing_buffer ) == 0 )
+kiibohd.Host_set_systick( c_uint32( 1000 + tx_timeout + 1 ) )
+
+
+# A single processing loop (receives, then sends packets)
+i.control.loop(1)
+logger.info(header("Check re-sent data packet"))
+logger.info("Outgoing Buf: {}", data.rawio_outgoing_buffer)
+check( len( data.rawio_outgoing_buffer ) == 1 )
+check( data.rawio_outgoing_buffer[0][0].type == 0 )
+check( data.rawio_outgoing_buffer[0][1] == 2 ) # Id check
+check( data.rawio_outgoing_buffer[0][2][0] == 0x42 ) # Payload check
+
+# ACK, then empty
+i.control.loop(2)
+logger.info(header("Check buffers are empty"))
+check( len( data.rawio_incoming_buffer ) == 0 )
+check( len( data.rawio_outgoing_buffer ) == 0 )
+kiibohd.Host_set_systick( c_uint32( 0 ) )
+
+
+
 # Worst-case Through-put Test (single byte payload)
 print("")
 logger.info(header("- Worst-case Through-put Test -"))
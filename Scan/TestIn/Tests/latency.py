@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+'''
+Latency histogram, percentile and key event trace test for Host-side KLL
+'''
+
+# Copyright (C) 2021 by Jacob Alexander
+#
+# This file is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This file is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this file.  If not, see <http://www.gnu.org/licenses/>.
+
+### Imports ###
+
+import logging
+import os
+import random
+
+from ctypes import (
+    c_char_p,
+    c_uint8,
+    c_uint16,
+    c_uint32,
+)
+
+import interface as i
+import kiilogger
+
+from common import (check, result, header)
+
+
+
+### Setup ###
+
+# Logger (current file and parent directory only)
+logger = kiilogger.get_logger(os.path.join(os.path.split(__file__)[0], os.path.basename(__file__)))
+logging.root.setLevel(logging.INFO)
+
+kiibohd = i.control.kiibohd
+kiibohd.Latency_query.restype = c_uint32
+kiibohd.Latency_percentile.restype = c_uint32
+kiibohd.Latency_bucket.restype = c_uint8
+kiibohd.Latency_bucket_lower.restype = c_uint32
+kiibohd.Latency_bucket_upper.restype = c_uint32
+kiibohd.Latency_bucket_count.restype = c_uint16
+kiibohd.Latency_add_resource.restype = c_uint8
+
+# LatencyQuery
+Query_Max = 1
+Query_Count = 4
+Query_P50 = 5
+Query_P95 = 6
+Query_P99 = 7
+Query_P999 = 8
+
+# Resource name must stay allocated
+name = c_char_p(b"LatencyTest")
+resource = c_uint8(kiibohd.Latency_add_resource(name, 0))
+
+
+
+### Functions ###
+
+def add(value, count=1):
+    '''
+    Add measurements to the test resource
+    '''
+    for _ in range(count):
+        kiibohd.Latency_add_measurement(resource, c_uint32(value))
+
+
+def query(query_type):
+    '''
+    Query the test resource
+    '''
+    return kiibohd.Latency_query(query_type, resource)
+
+
+def bucket_range(value):
+    '''
+    Range of values that share a histogram bucket with the given value
+    '''
+    bucket = kiibohd.Latency_bucket(c_uint32(value))
+    return kiibohd.Latency_bucket_lower(bucket), kiibohd.Latency_bucket_upper(bucket)
+
+
+
+### Test ###
+
+logger.info(header("-- Latency histogram buckets --"))
+
+# Every value must fall within the bounds of its bucket, buckets are at most a factor of 2 wide
+rand = random.Random(0x1a7)
+values = list(range(0, 4096)) + [rand.getrandbits(32) for _ in range(4096)] + [0xFFFFFFFF]
+bad = 0
+for value in values:
+    lower, upper = bucket_range(value)
+    if not (lower <= value <= upper) or (lower > 0 and upper >= lower * 2 and upper != 0xFFFFFFFF):
+        bad += 1
+check(bad == 0)
+
+
+logger.info(header("-- Latency percentiles --"))
+
+# 99% fast, 0.9% slow and a single outlier
+add(100, 990)
+add(1000, 9)
+add(50000)
+
+check(query(Query_Count) == 1000)
+check(query(Query_Max) == 50000)
+for query_type, value in ((Query_P50, 100), (Query_P95, 100), (Query_P99, 100), (Query_P999, 1000)):
+    lower, upper = bucket_range(value)
+    logger.info("Query {}: {} ({}..{})", query_type, query(query_type), lower, upper)
+    check(lower <= query(query_type) <= upper)
+check(kiibohd.Latency_percentile(c_uint16(1000), resource) == 50000)
+
+
+logger.info(header("-- Latency reset --"))
+
+kiibohd.Latency_reset(resource)
+check(query(Query_Count) == 0)
+check(query(Query_P50) == 0)
+check(query(Query_Max) == 0)
+
+
+logger.info(header("-- Latency histogram decay --"))
+
+# Overflowing a bucket halves the histogram, percentiles must still hold
+add(10, 0x10000 + 100)
+add(10000, 100)
+bucket = kiibohd.Latency_bucket(c_uint32(10))
+check(query(Query_Count) == 0x10000 + 200)
+check(kiibohd.Latency_bucket_count(bucket, resource) < 0x10000)
+lower, upper = bucket_range(10)
+check(lower <= query(Query_P99) <= upper)
+lower, upper = bucket_range(10000)
+check(lower <= kiibohd.Latency_percentile(c_uint16(1000), resource) <= upper)
+
+kiibohd.Latency_reset(resource)
+
+
+logger.info(header("-- Key latency trace --"))
+
+kiibohd.Trace_keyEvent.restype = c_uint16
+kiibohd.Trace_lookup.restype = c_uint16
+trace_current = c_uint16.in_dll(kiibohd, 'Trace_current')
+
+# Key press at 1000 ms, USB report sent at 1003 ms
+kiibohd.Host_set_systick(c_uint32(1000))
+trace = kiibohd.Trace_keyEvent(c_uint8(0x00), c_uint8(0x21), c_uint8(0x01))
+check(trace != 0)
+check(kiibohd.Trace_lookup(c_uint8(0x00), c_uint8(0x21), c_uint8(0x01)) == trace)
+check(kiibohd.Trace_lookup(c_uint8(0x00), c_uint8(0x21), c_uint8(0x03)) == 0)
+
+# Hold events are not traced
+check(kiibohd.Trace_keyEvent(c_uint8(0x00), c_uint8(0x21), c_uint8(0x02)) == 0)
+
+trace_current.value = trace
+kiibohd.Trace_report()
+trace_current.value = 0
+
+kiibohd.Host_set_systick(c_uint32(1003))
+kiibohd.Trace_reportSent()
+
+record = i.control.cmd('traceRecords')()[0]
+logger.info("Trace: {}", record)
+check(record.id == trace)
+check(record.sent == 1)
+check(record.latency == 3000)
+
+# Sent events are no longer looked up
+check(kiibohd.Trace_lookup(c_uint8(0x00), c_uint8(0x21), c_uint8(0x01)) == 0)
+
+# End-to-end, key press to USB report
+i.control.cmd('addScanCode')(0x01)
+i.control.loop(1)
+record = i.control.cmd('traceRecords')()[0]
+logger.info("Trace: {}", record)
+check(record.index == 0x01)
+check(record.state == 0x01)
+check(record.sent == 1)
+i.control.cmd('removeScanCode')(0x01)
+i.control.loop(1)
+record = i.control.cmd('traceRecords')()[0]
+check(record.state == 0x03)
+check(record.sent == 1)
+
+
+
+### Results ###
+
+result()
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+'''
+Layer lookup table test and benchmark for Host-side KLL
+'''
+
+# Copyright (C) 2020 by Jacob Alexander
+#
+# This file is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This file is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this file.  If not, see <http://www.gnu.org/licenses/>.
+
+### Imports ###
+
+import logging
+import os
+import time
+
+from ctypes import (
+    byref,
+    c_uint8,
+    c_uint32,
+    c_void_p,
+    cast,
+    POINTER,
+)
+
+import interface as i
+import kiilogger
+
+from common import (check, result, header)
+
+
+
+### Setup ###
+
+# Logger (current file and parent directory only)
+logger = kiilogger.get_logger(os.path.join(os.path.split(__file__)[0], os.path.basename(__file__)))
+logging.root.setLevel(logging.INFO)
+
+# Number of benchmark rounds (each round looks up every scancode)
+rounds = 200
+
+kiibohd = i.control.kiibohd
+kiibohd.Layer_layerLookup.restype = c_void_p
+kiibohd.Layer_layerLookupStack.restype = c_void_p
+
+layerNum = cast(kiibohd.LayerNum_host, POINTER(c_uint32)).contents.value
+scancodes = range(0, 256)
+
+
+
+### Functions ###
+
+def lookup_all(func, events):
+    '''
+    Lookup every event using the given lookup function
+
+    @param func:   Lookup function
+    @param events: List of TriggerEvents
+
+    @return: List of trigger list pointers
+    '''
+    return [func(byref(event), c_uint8(0)) for event in events]
+
+
+def check_table(events):
+    '''
+    Check the lookup table against a layer stack walk for every event
+
+    @param events: List of TriggerEvents
+    '''
+    check(lookup_all(kiibohd.Layer_layerLookup, events) == lookup_all(kiibohd.Layer_layerLookupStack, events))
+
+
+def layer_capability(name, state, layer):
+    '''
+    Call a layer capability (Switch1)
+
+    @param name:  Capability name (layerShift, layerLatch, layerLock)
+    @param state: 0x1 Press, 0x3 Release
+    @param layer: Layer index
+    '''
+    i.control.cmd('capability')(name, None, state, 0x0, [layer])
+
+
+def bench(func, events):
+    '''
+    Time the given lookup function
+
+    @param func:   Lookup function
+    @param events: List of TriggerEvents
+
+    @return: ns per lookup
+    '''
+    start = time.perf_counter()
+    for _ in range(rounds):
+        for event in events:
+            func(byref(event), c_uint8(0))
+    return (time.perf_counter() - start) * 1e9 / (rounds * len(events))
+
+
+
+### Test ###
+
+logger.info(header("-- Layer lookup table --"))
+
+# Press events for every scancode index
+events = [i.lib.TriggerEvent(type=0, state=0x01, index=index) for index in scancodes]
+
+# Shift, latch and lock transitions (Layer_layerStateSet), checking the table against a layer stack walk at each step
+i.control.cmd('clearLayers')()
+for layer in range(1, layerNum):
+    # Shift press/release
+    layer_capability('layerShift', 0x1, layer)
+    check_table(events)
+    layer_capability('layerShift', 0x3, layer)
+    check_table(events)
+
+    # Latch, then shift on top (two states set, layer is not used)
+    layer_capability('layerLatch', 0x3, layer)
+    check_table(events)
+    layer_capability('layerShift', 0x1, layer)
+    check_table(events)
+    layer_capability('layerShift', 0x3, layer)
+    check_table(events)
+    layer_capability('layerLatch', 0x3, layer)
+    check_table(events)
+
+# Layer_clearLayers with shifted and latched layers
+for layer in range(1, layerNum):
+    layer_capability('layerShift' if layer % 2 else 'layerLatch', 0x1 if layer % 2 else 0x3, layer)
+check_table(events)
+kiibohd.Layer_clearLayers()
+check_table(events)
+
+# Stack every layer
+i.control.cmd('clearLayers')()
+for layer in range(1, layerNum):
+    i.control.cmd('lockLayer')(layer)
+    check_table(events)
+
+# Shift/latch on top of the locked stack
+for layer in range(1, layerNum):
+    layer_capability('layerShift', 0x1, layer)
+    check_table(events)
+    layer_capability('layerLatch', 0x3, layer)
+    check_table(events)
+
+# Benchmark with all layers stacked
+logger.info(header("-- Layer lookup benchmark ({} layers) --".format(layerNum)))
+
+# Baseline for ctypes call overhead
+baseline = bench(lambda event, latch: kiibohd.Layer_topActive(), events)
+stack = bench(kiibohd.Layer_layerLookupStack, events) - baseline
+table = bench(kiibohd.Layer_layerLookup, events) - baseline
+
+logger.info("ctypes overhead:  {:.1f} ns/event", baseline)
+logger.info("Layer stack walk: {:.1f} ns/event", stack)
+logger.info("Lookup table:     {:.1f} ns/event", table)
+
+# Cleanup
+kiibohd.Layer_clearLayers()
+i.control.cmd('clearMacroTriggerEventBuffer')()
+check_table(events)
+
+
+
+### Results ###
+
+result()
@@ -0,0 +1,469 @@
+/* Copyright (C) 2020 by Jacob Alexander
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+// Native host benchmark
+// Replays key event streams through the Scan -> Macro -> Output pipeline without Python
+// Each periodic stage is timed using the host clock, results are collected using Latency resources
+//
+// Usage: kiibohd_bench [-n presses] [-r presses/s] [-H hold ms] [-s seed] [-f recorded stream]
+//
+// Recorded stream format (one event per line, sorted by time, # for comments)
+//  <ms> <scancode> <P|R>
+
+// ----- Includes -----
+
+// Compiler Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Project Includes
+#include <kll_defs.h>
+#include <kll.h>
+#include <latency.h>
+#include <macro.h>
+#include <output_com.h>
+#include <scan_loop.h>
+
+
+
+// ----- Defines -----
+
+// Maximum number of keys held at the same time (synthetic stream)
+#define Bench_MaxHeld 16
+
+// Cycles to run after the last event, lets the Macro and Output modules flush
+#define Bench_DrainCycles 10
+
+
+
+// ----- Enumerations -----
+
+typedef enum BenchStage {
+	BenchStage_Scan,
+	BenchStage_Macro,
+	BenchStage_Output,
+	BenchStage_Poll,
+	BenchStage_Count,
+} BenchStage;
+
+
+
+// ----- Structs -----
+
+typedef struct BenchEvent {
+	uint32_t ms;       // Simulated time of the event
+	uint16_t scanCode;
+	uint8_t  state;    // ScheduleType_P or ScheduleType_R
+} BenchEvent;
+
+typedef struct BenchKey {
+	uint16_t scanCode;
+	uint32_t press;    // Simulated time the key was pressed
+	uint32_t release;  // Simulated time to release the key (synthetic stream only)
+} BenchKey;
+
+
+
+// ----- Function Declarations -----
+
+// main.c host functions
+int Host_init();
+int Host_poll();
+int Host_register_callback( void* func );
+int Host_set_systick( uint32_t systick_ms );
+
+
+
+// ----- Variables -----
+
+static const char *bench_stage_names[] = {
+	"Scan",
+	"Macro",
+	"Output",
+	"Poll",
+};
+
+static uint8_t  bench_stage_resource[BenchStage_Count];
+static uint32_t bench_reports;
+
+// Keys currently held
+static BenchKey bench_held[Bench_MaxHeld];
+static uint8_t  bench_held_count;
+
+// Event counters
+static uint32_t bench_presses;
+static uint32_t bench_releases;
+
+
+
+// ----- Functions -----
+
+// Host callback, replaces the Python callbacks
+static int Bench_callback( char* command, char* args )
+{
+	// USB keyboard report sent
+	if ( strcmp( command, "keyboard_send" ) == 0 )
+	{
+		bench_reports++;
+		return 1;
+	}
+
+	// Nothing to read (virtual serial port and HID-IO)
+	if ( strcmp( command, "serial_available" ) == 0 || strcmp( command, "rawio_available" ) == 0 )
+	{
+		return 0;
+	}
+
+	// Ignore everything else (e.g. serial_write)
+	return 1;
+}
+
+// Host clock in ns
+static uint64_t Bench_now()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Key transition, as reported by a scan module
+static void Bench_keyEvent( uint16_t scanCode, uint8_t state )
+{
+	Macro_keyState( scanCode, state );
+
+	if ( state == ScheduleType_P )
+	{
+		bench_presses++;
+	}
+	else
+	{
+		bench_releases++;
+	}
+}
+
+// Synthetic stream
+// Presses random keys at the given rate, each key is released after hold ms
+// Returns 1 while there are events left to generate
+static uint8_t Bench_synthetic( uint32_t now, uint32_t presses, uint32_t rate, uint32_t hold, uint32_t *credit )
+{
+	// Release keys
+	for ( uint8_t pos = 0; pos < bench_held_count; )
+	{
+		if ( bench_held[pos].release <= now )
+		{
+			Bench_keyEvent( bench_held[pos].scanCode, ScheduleType_R );
+			bench_held[pos] = bench_held[--bench_held_count];
+			continue;
+		}
+		pos++;
+	}
+
+	// Press keys (rate is in presses per second, one cycle is 1 ms)
+	*credit += rate;
+	while ( *credit >= 1000 && bench_presses < presses && bench_held_count < Bench_MaxHeld )
+	{
+		*credit -= 1000;
+
+		// Select a key that isn't already held
+		uint16_t scanCode;
+		uint8_t held;
+		do {
+			scanCode = 1 + rand() % MaxScanCode_KLL;
+			held = 0;
+			for ( uint8_t pos = 0; pos < bench_held_count; pos++ )
+			{
+				if ( bench_held[pos].scanCode == scanCode )
+				{
+					held = 1;
+				}
+			}
+		} while ( held );
+
+		Bench_keyEvent( scanCode, ScheduleType_P );
+		bench_held[bench_held_count].scanCode = scanCode;
+		bench_held[bench_held_count].press = now;
+		bench_held[bench_held_count].release = now + hold;
+		bench_held_count++;
+	}
+
+	// Don't accumulate credit while keys can't be pressed
+	if ( *credit > 1000 )
+	{
+		*credit = 1000;
+	}
+
+	return bench_presses < presses || bench_held_count > 0;
+}
+
+// Recorded stream
+// Returns 1 while there are events left to replay
+static uint8_t Bench_recorded( uint32_t now, BenchEvent *events, uint32_t count, uint32_t *pos )
+{
+	while ( *pos < count && events[*pos].ms <= now )
+	{
+		BenchEvent *event = &events[(*pos)++];
+		Bench_keyEvent( event->scanCode, event->state );
+
+		// Track held keys
+		if ( event->state == ScheduleType_P && bench_held_count < Bench_MaxHeld )
+		{
+			bench_held[bench_held_count].scanCode = event->scanCode;
+			bench_held[bench_held_count].press = now;
+			bench_held_count++;
+		}
+		else if ( event->state == ScheduleType_R )
+		{
+			for ( uint8_t held = 0; held < bench_held_count; held++ )
+			{
+				if ( bench_held[held].scanCode == event->scanCode )
+				{
+					bench_held[held] = bench_held[--bench_held_count];
+					break;
+				}
+			}
+		}
+	}
+
+	return *pos < count;
+}
+
+// Load recorded stream
+// Returns number of events, events must be freed
+static uint32_t Bench_load( const char *path, BenchEvent **events )
+{
+	FILE *file = fopen( path, "r" );
+	if ( file == NULL )
+	{
+		fprintf( stderr, "Could not open %s\n", path );
+		exit( 1 );
+	}
+
+	uint32_t count = 0;
+	uint32_t size = 256;
+	*events = malloc( size * sizeof( BenchEvent ) );
+	if ( *events == NULL )
+	{
+		fprintf( stderr, "Out of memory loading %s\n", path );
+		exit( 1 );
+	}
+
+	char line[128];
+	while ( fgets( line, sizeof( line ), file ) )
+	{
+		unsigned int ms;
+		unsigned int scanCode;
+		char state;
+		if ( line[0] == '#' || sscanf( line, "%u %u %c", &ms, &scanCode, &state ) != 3 )
+		{
+			continue;
+		}
+
+		if ( count == size )
+		{
+			size *= 2;
+			BenchEvent *resized = realloc( *events, size * sizeof( BenchEvent ) );
+			if ( resized == NULL )
+			{
+				fprintf( stderr, "Out of memory loading %s\n", path );
+				exit( 1 );
+			}
+			*events = resized;
+		}
+
+		(*events)[count].ms = ms;
+		(*events)[count].scanCode = scanCode;
+		(*events)[count].state = state == 'R' ? ScheduleType_R : ScheduleType_P;
+		count++;
+	}
+
+	fclose( file );
+	return count;
+}
+
+// Find latency resource by name
+// Returns 0xFF if not found
+static uint8_t Bench_resource( const char *name )
+{
+	for ( uint8_t resource = 0; resource < Latency_resources(); resource++ )
+	{
+		if ( strcmp( Latency_query_name( resource ), name ) == 0 )
+		{
+			return resource;
+		}
+	}
+	return 0xFF;
+}
+
+int main( int argc, char **argv )
+{
+	uint32_t presses = 10000;
+	uint32_t rate = 100;
+	uint32_t hold = 50;
+	unsigned int seed = 1;
+	const char *path = NULL;
+
+	int opt;
+	while ( ( opt = getopt( argc, argv, "n:r:H:s:f:" ) ) != -1 )
+	{
+		switch ( opt )
+		{
+		case 'n':
+			presses = strtoul( optarg, NULL, 0 );
+			break;
+		case 'r':
+			rate = strtoul( optarg, NULL, 0 );
+			break;
+		case 'H':
+			hold = strtoul( optarg, NULL, 0 );
+			break;
+		case 's':
+			seed = strtoul( optarg, NULL, 0 );
+			break;
+		case 'f':
+			path = optarg;
+			break;
+		default:
+			fprintf( stderr, "Usage: %s [-n presses] [-r presses/s] [-H hold ms] [-s seed] [-f recorded stream]\n", argv[0] );
+			return 1;
+		}
+	}
+	srand( seed );
+
+	// Load recorded stream
+	BenchEvent *events = NULL;
+	uint32_t event_count = 0;
+	uint32_t event_pos = 0;
+	if ( path != NULL )
+	{
+		event_count = Bench_load( path, &events );
+	}
+
+	// Setup modules
+	Host_register_callback( (void*)&Bench_callback );
+	Host_set_systick( 0 );
+	Host_init();
+
+	// Per stage latency resources
+	if ( Latency_resources() + BenchStage_Count > LatencyMeasurementCount_define )
+	{
+		fprintf( stderr, "Not enough latency resources, increase latencyResources\n" );
+		return 1;
+	}
+	for ( uint8_t stage = 0; stage < BenchStage_Count; stage++ )
+	{
+		bench_stage_resource[stage] = Latency_add_resource( bench_stage_names[stage], LatencyOption_ns );
+	}
+
+	// Run pipeline, one cycle per simulated ms
+	uint64_t total[BenchStage_Count] = { 0 };
+	uint32_t credit = 0;
+	uint32_t drain = Bench_DrainCycles;
+	uint32_t now = 0;
+	for ( ; drain > 0; now++ )
+	{
+		Host_set_systick( now );
+		uint64_t times[BenchStage_Count + 1];
+
+		// Scan: key transitions, then keys held since a previous scan (like a matrix scan)
+		// A key pressed this scan only reports the press
+		times[BenchStage_Scan] = Bench_now();
+		uint8_t active = path != NULL
+			? Bench_recorded( now, events, event_count, &event_pos )
+			: Bench_synthetic( now, presses, rate, hold, &credit );
+		for ( uint8_t pos = 0; pos < bench_held_count; pos++ )
+		{
+			if ( bench_held[pos].press < now )
+			{
+				Macro_keyState( bench_held[pos].scanCode, ScheduleType_H );
+			}
+		}
+		Scan_periodic();
+
+		times[BenchStage_Macro] = Bench_now();
+		Macro_periodic();
+
+		times[BenchStage_Output] = Bench_now();
+		Output_periodic();
+
+		times[BenchStage_Poll] = Bench_now();
+		Host_poll();
+
+		times[BenchStage_Count] = Bench_now();
+		for ( uint8_t stage = 0; stage < BenchStage_Count; stage++ )
+		{
+			uint64_t duration = times[stage + 1] - times[stage];
+			total[stage] += duration;
+			Latency_add_measurement( bench_stage_resource[stage], duration );
+		}
+
+		// Finish once all events have been processed
+		if ( !active )
+		{
+			drain--;
+		}
+	}
+
+	// Results
+	uint64_t pipeline = 0;
+	for ( uint8_t stage = 0; stage < BenchStage_Count; stage++ )
+	{
+		pipeline += total[stage];
+	}
+	uint32_t key_events = bench_presses + bench_releases;
+
+	printf( "Cycles:      %u (1 ms simulated each)\n", now );
+	printf( "Key events:  %u (%u presses, %u releases)\n", key_events, bench_presses, bench_releases );
+	printf( "USB reports: %u\n", bench_reports );
+	printf( "Throughput:  %.0f events/s, %.0f cycles/s\n",
+		pipeline ? key_events * 1e9 / pipeline : 0.0,
+		pipeline ? now * 1e9 / pipeline : 0.0
+	);
+	printf( "\n%-8s %10s %10s %10s %10s %10s\n", "Stage", "avg ns", "p50 ns", "p99 ns", "max ns", "total ms" );
+	for ( uint8_t stage = 0; stage < BenchStage_Count; stage++ )
+	{
+		uint8_t resource = bench_stage_resource[stage];
+		printf( "%-8s %10.0f %10u %10u %10u %10.3f\n",
+			bench_stage_names[stage],
+			(double)total[stage] / now,
+			Latency_query( LatencyQuery_P50, resource ),
+			Latency_query( LatencyQuery_P99, resource ),
+			Latency_query( LatencyQuery_Max, resource ),
+			total[stage] / 1e6
+		);
+	}
+
+	// Key event to USB report latency (simulated time)
+	uint8_t trace = Bench_resource( "KeyToUSB" );
+	if ( trace != 0xFF && Latency_query( LatencyQuery_Count, trace ) > 0 )
+	{
+		printf( "\nKeyToUSB (simulated): avg %u us, p99 %u us, max %u us\n",
+			Latency_query( LatencyQuery_Average, trace ),
+			Latency_query( LatencyQuery_P99, trace ),
+			Latency_query( LatencyQuery_Max, trace )
+		);
+	}
+
+	free( events );
+	return 0;
+}
@@ -157,6 +157,7 @@ class ResultCapabilityStackItem( Structure ):
         ( "stateType",       c_uint8 ),
         ( "capabilityIndex", c_uint8 ),
         ( "args",            POINTER( c_uint8 ) ),
+        ( "trace",           c_uint16 ),
     ]
 
     def copy(self):
@@ -169,6 +170,7 @@ class ResultCapabilityStackItem( Structure ):
         val.stateType = copy.copy(self.stateType)
         val.capabilityIndex = copy.copy(self.capabilityIndex)
         val.args = self.args
+        val.trace = copy.copy(self.trace)
         return val
 
     def read_capability(self):
@@ -244,6 +246,34 @@ class ResultCapabilityStackItem( Structure ):
         return val
 
 
+class TraceRecord( Structure ):
+    '''
+    C-Struct for TraceRecord
+    See Macro/PartialMap/trace.h
+    '''
+    _fields_ = [
+        ( "id",          c_uint16 ),
+        ( "type",        c_uint8 ),
+        ( "index",       c_uint8 ),
+        ( "state",       c_uint8 ),
+        ( "sent",        c_uint8 ),
+        ( "start_ms",    c_uint32 ),
+        ( "start_ticks", c_uint32 ),
+        ( "latency",     c_uint32 ),
+    ]
+
+    def __repr__(self):
+        val = "(id={}, type={}, index={}, state={}, sent={}, latency={})".format(
+            self.id,
+            self.type,
+            self.index,
+            self.state,
+            self.sent,
+            self.latency,
+        )
+        return val
+
+
 class AnimationStackElement( Structure ):
     '''
     C-Struct for AnimationStackElement
@@ -505,6 +535,22 @@ class Commands:
         Clears the macroTriggerEventBuffer to make sure no old events are processed.
         '''
         cast( control.kiibohd.macroTriggerEventBufferSize, POINTER( control.var_uint_t ) )[0] = 0
+        control.kiibohd.Macro_clearTriggerEventQueue()
+
+    def traceRecords( self ):
+        '''
+        Returns the most recent key event latency traces (most recent first)
+
+        Latency is in us, only valid if the USB report has been sent
+        '''
+        control.kiibohd.Trace_record.restype = POINTER( TraceRecord )
+        records = []
+        for pos in range( control.kiibohd.Trace_records() ):
+            record = control.kiibohd.Trace_record( c_uint8( pos ) )
+            if not record:
+                break
+            records.append( record.contents )
+        return records
 
     def addAnimation( self, name=None, index=0, pos=0, loops=1, divmask=0x0, divshift=0x0, ffunc=0, pfunc=0 ):
         '''
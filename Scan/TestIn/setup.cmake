@@ -18,6 +18,18 @@
 
 set ( Module_SRCS
 	scan_loop.c
+
+	# Matrix debounce engine (hardware independent)
+	${HEAD_DIR}/Scan/Devices/MatrixARMPeriodic/debounce.c
+)
+
+
+###
+# Native host benchmark (Scan -> Macro -> Output pipeline)
+# Linked against the static library, see Lib/CMake/build.cmake
+#
+set ( HostBench_SRCS
+	${HEAD_DIR}/Scan/TestIn/bench.c
 )
 
 
@@ -45,9 +57,13 @@ configure_file ( Scan/TestIn/Tests/kiilogger.py  Tests/kiilogger.py  COPYONLY )
 
 configure_file ( Scan/TestIn/Tests/test.py       Tests/test.py       COPYONLY )
 configure_file ( Scan/TestIn/Tests/kll.py        Tests/kll.py        COPYONLY )
+configure_file ( Scan/TestIn/Tests/latency.py    Tests/latency.py    COPYONLY )
 configure_file ( Scan/TestIn/Tests/layers.py     Tests/layers.py     COPYONLY )
+configure_file ( Scan/TestIn/Tests/layerlookup.py Tests/layerlookup.py COPYONLY )
 configure_file ( Scan/TestIn/Tests/animation.py  Tests/animation.py  COPYONLY )
 configure_file ( Scan/TestIn/Tests/animation2.py Tests/animation2.py COPYONLY )
 configure_file ( Scan/TestIn/Tests/cli.py        Tests/cli.py        COPYONLY )
+configure_file ( Scan/TestIn/Tests/debounce.py   Tests/debounce.py   COPYONLY )
+configure_file ( Scan/TestIn/Tests/fade.py       Tests/fade.py       COPYONLY )
 configure_file ( Scan/TestIn/Tests/hidio.py      Tests/hidio.py      COPYONLY )
 
@@ -59,6 +59,19 @@ static volatile PeriodicStage stage_tracker;
 
 // ----- Functions -----
 
+// Output module periodic routines
+// Skipped while Macro_poll is running a delayed capability, as those capabilities may not be safe to run
+// alongside Output_periodic (e.g. USB protocol/flash mode changes). Pending output is sent on the next stage.
+static void main_output()
+{
+	if ( __atomic_load_n( &macroResultDelayedActive, __ATOMIC_ACQUIRE ) )
+		return;
+
+	SEGGER_SYSVIEW_OnTaskStartExec(TASK_OUTPUT_PERIODIC);
+	Output_periodic();
+	SEGGER_SYSVIEW_OnTaskTerminate(TASK_OUTPUT_PERIODIC);
+}
+
 // Run periodically at a consistent time rate
 // Used to process events that need to be run at regular intervals
 // And have negative effect being delayed or stretched too much
@@ -67,6 +80,32 @@ static volatile PeriodicStage stage_tracker;
 // Returns 0 otherwise
 int main_periodic()
 {
+#if USBSOFSync_define == 1
+	// USB SOF synchronized output
+	// The periodic timer is re-phased on each USB SOF, the output stage is run on the tick just before
+	// the next SOF (minus the lead time) instead of after each macro stage
+	// Falls back to the normal rotation if there hasn't been a SOF within the last frame
+	uint16_t frame_ticks = Periodic_ticksPerMs();
+	uint16_t sof_ticks = Periodic_syncTicks();
+	uint8_t sof_sync = frame_ticks > 1 && sof_ticks <= frame_ticks;
+	if ( sof_sync )
+	{
+		uint16_t lead_ticks = ( USBSOFLead_define * frame_ticks + 999 ) / 1000;
+		if ( lead_ticks < 1 )
+			lead_ticks = 1;
+		if ( lead_ticks >= frame_ticks )
+			lead_ticks = frame_ticks - 1;
+
+		// Output once per frame, as soon as the lead time is reached
+		// (an overrunning periodic call may skip past the exact tick)
+		if ( sof_ticks + lead_ticks >= frame_ticks && Periodic_syncClaim() )
+		{
+			main_output();
+			return 0;
+		}
+	}
+#endif
+
 	// Scan module periodic routines
 	switch ( stage_tracker )
 	{
@@ -86,14 +125,21 @@ int main_periodic()
 		Macro_periodic();
 		stage_tracker = PeriodicStage_Output;
 		SEGGER_SYSVIEW_OnTaskTerminate(TASK_MACRO_PERIODIC);
+
+#if USBSOFSync_define == 1
+		// Output stage is run separately, aligned to SOF
+		if ( sof_sync )
+		{
+			stage_tracker = PeriodicStage_Scan;
+			return 1;
+		}
+#endif
 		break;
 
 	case PeriodicStage_Output:
 		// Send periodic USB results
-		SEGGER_SYSVIEW_OnTaskStartExec(TASK_OUTPUT_PERIODIC);
-		Output_periodic();
+		main_output();
 		stage_tracker = PeriodicStage_Scan;
-		SEGGER_SYSVIEW_OnTaskTerminate(TASK_OUTPUT_PERIODIC);
 
 		// Full rotation
 		return 1;